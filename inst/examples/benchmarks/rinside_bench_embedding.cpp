@@ -0,0 +1,206 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Cost of the embedding layer itself: construction, parseEval() on trivial
+// expressions, assign / operator[] round trips by type and size, Proxy
+// conversions and, with callbacks compiled in, console throughput
+//
+// Results go to stdout as one JSON document so that runs of different
+// RInside versions can be compared; progress goes to stderr.
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <Timing.h>
+#include <algorithm>
+#include <cstdio>
+
+struct Result {
+    std::string name;
+    long size;
+    std::vector<double> usec;           // one per iteration
+    double bytes;                       // moved per iteration, 0 if not meaningful
+};
+
+static std::vector<Result> results;
+
+// a benchmark runs its body 'iter' times per sample
+class Bench {
+public:
+    virtual ~Bench() {}
+    virtual void setup(RInside& R, long n) {}
+    virtual void run(RInside& R, long n) = 0;
+};
+
+static void measure(RInside& R, const char* name, Bench& b, long n = 0, double bytes = 0) {
+    const double budget = 250000;       // usec per benchmark
+    const int maxSamples = 2000;
+    b.setup(R, n);
+    b.run(R, n);                        // warm up
+    Result res;
+    res.name = name;
+    res.size = n;
+    res.bytes = bytes;
+    double total = 0;
+    while (total < budget && (int) res.usec.size() < maxSamples) {
+        double t0 = monotonicUsec();
+        b.run(R, n);
+        double t = monotonicUsec() - t0;
+        res.usec.push_back(t);
+        total += t;
+    }
+    fprintf(stderr, "%-24s %8ld  %6lu samples\n", name, n, (unsigned long) res.usec.size());
+    results.push_back(res);
+}
+
+static double quantile(const std::vector<double>& sorted, double q) {
+    return sorted[std::min(sorted.size() - 1, (size_t) (q * sorted.size()))];
+}
+
+static void report(const std::string& version) {
+    printf("{\n  \"rinside\": \"%s\",\n  \"benchmarks\": [\n", version.c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+        std::vector<double> s = results[i].usec;
+        std::sort(s.begin(), s.end());
+        double sum = 0;
+        for (size_t j = 0; j < s.size(); j++) sum += s[j];
+        printf("    {\"name\": \"%s\", \"size\": %ld, \"samples\": %lu, "
+               "\"min_usec\": %.3f, \"median_usec\": %.3f, \"p90_usec\": %.3f, \"mean_usec\": %.3f",
+               results[i].name.c_str(), results[i].size, (unsigned long) s.size(),
+               s.front(), quantile(s, 0.5), quantile(s, 0.9), sum / s.size());
+        if (results[i].bytes > 0) {
+            printf(", \"bytes_per_sec\": %.0f", results[i].bytes / (quantile(s, 0.5) * 1e-6));
+        }
+        printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+class ParseEvalQ : public Bench {
+    void run(RInside& R, long n) { R.parseEvalQ("NULL"); }
+};
+
+class ParseEvalSexp : public Bench {
+    void run(RInside& R, long n) { SEXP ans; R.parseEval("1L", ans); }
+};
+
+class ParseEvalProxy : public Bench {
+    void run(RInside& R, long n) { double d = R.parseEval("1"); (void) d; }
+};
+
+class AssignScalar : public Bench {
+    void run(RInside& R, long n) { R["x"] = 3.14; }
+};
+
+class ReadScalar : public Bench {
+    void setup(RInside& R, long n) { R["x"] = 3.14; }
+    void run(RInside& R, long n) { double d = R["x"]; (void) d; }
+};
+
+class AssignVector : public Bench {
+    std::vector<double> v;
+    void setup(RInside& R, long n) { v.assign(n, 1.5); }
+    void run(RInside& R, long n) { R["v"] = v; }
+};
+
+class ReadVector : public Bench {
+    void setup(RInside& R, long n) { R["v"] = std::vector<double>(n, 1.5); }
+    void run(RInside& R, long n) { std::vector<double> v = R["v"]; }
+};
+
+class AssignStrings : public Bench {
+    std::vector<std::string> v;
+    void setup(RInside& R, long n) { v.assign(n, "abcdefgh"); }
+    void run(RInside& R, long n) { R["s"] = v; }
+};
+
+class ReadStrings : public Bench {
+    void setup(RInside& R, long n) { R["s"] = std::vector<std::string>(n, "abcdefgh"); }
+    void run(RInside& R, long n) { std::vector<std::string> v = R["s"]; }
+};
+
+class AssignDataFrame : public Bench {
+    std::vector<double> x;
+    std::vector<int> k;
+    std::vector<std::string> s;
+    void setup(RInside& R, long n) { x.assign(n, 0.5); k.assign(n, 7); s.assign(n, "level"); }
+    void run(RInside& R, long n) {
+        R["df"] = Rcpp::DataFrame::create(Rcpp::Named("x") = x, Rcpp::Named("k") = k,
+                                          Rcpp::Named("s") = s, Rcpp::Named("stringsAsFactors") = false);
+    }
+};
+
+class ReadDataFrame : public Bench {
+    void setup(RInside& R, long n) {
+        R["n"] = (int) n;
+        R.parseEvalQ("df <- data.frame(x = rep(0.5, n), k = rep(7L, n), s = rep('level', n), stringsAsFactors = FALSE)");
+    }
+    void run(RInside& R, long n) {
+        Rcpp::DataFrame df = R["df"];
+        std::vector<double> x = Rcpp::as<std::vector<double> >(df["x"]);
+        std::vector<std::string> s = Rcpp::as<std::vector<std::string> >(df["s"]);
+    }
+};
+
+class ProxyVector : public Bench {
+    void setup(RInside& R, long n) { R["n"] = (int) n; }
+    void run(RInside& R, long n) { std::vector<double> v = R.parseEval("as.numeric(seq_len(n))"); }
+};
+
+#ifdef RINSIDE_CALLBACKS
+class CountingCallbacks : public Callbacks {
+public:
+    CountingCallbacks() : bytes(0) {}
+    virtual void WriteConsole(const std::string& line, int type) { bytes += line.size(); }
+    virtual bool has_WriteConsole() { return true; }
+    size_t bytes;
+};
+
+class ConsoleLines : public Bench {
+    void setup(RInside& R, long n) { R["n"] = (int) n; }
+    void run(RInside& R, long n) { R.parseEvalQ("cat(rep('0123456789012345678901234567890123456789\\n', n), sep = '')"); }
+};
+#endif
+
+int main(int argc, char *argv[]) {
+
+    double t0 = monotonicUsec();
+    RInside R(argc, argv);              // create an embedded R instance
+    Result ctor;                        // once per process, see rinside_bench_startup for more
+    ctor.name = "construct";
+    ctor.size = 0;
+    ctor.bytes = 0;
+    ctor.usec.push_back(monotonicUsec() - t0);
+    results.push_back(ctor);
+
+    std::string version = Rcpp::as<std::string>(R.parseEval("as.character(packageVersion('RInside'))"));
+
+    ParseEvalQ peq;        measure(R, "parseEvalQ_null", peq);
+    ParseEvalSexp pes;     measure(R, "parseEval_sexp", pes);
+    ParseEvalProxy pep;    measure(R, "parseEval_proxy_double", pep);
+    AssignScalar as;       measure(R, "assign_scalar", as);
+    ReadScalar rs;         measure(R, "read_scalar", rs);
+
+    const long sizes[] = { 10, 1000, 100000 };
+    for (int i = 0; i < 3; i++) {
+        long n = sizes[i];
+        AssignVector av;    measure(R, "assign_vector", av, n, n * sizeof(double));
+        ReadVector rv;      measure(R, "read_vector", rv, n, n * sizeof(double));
+        AssignStrings ast;  measure(R, "assign_strings", ast, n);
+        ReadStrings rst;    measure(R, "read_strings", rst, n);
+        AssignDataFrame ad; measure(R, "assign_data_frame", ad, n);
+        ReadDataFrame rd;   measure(R, "read_data_frame", rd, n);
+        ProxyVector pv;     measure(R, "parseEval_proxy_vector", pv, n, n * sizeof(double));
+    }
+
+#ifdef RINSIDE_CALLBACKS
+    CountingCallbacks* cb = new CountingCallbacks;
+    R.set_callbacks(cb);
+    const long lines[] = { 1, 100, 10000 };
+    for (int i = 0; i < 3; i++) {
+        ConsoleLines cl;    measure(R, "console_lines", cl, lines[i], lines[i] * 41.0);
+    }
+#endif
+
+    report(version);
+    exit(0);
+}
@@ -0,0 +1,120 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Throughput and latency of scoring a fitted model via ModelScorer, both
+// synchronously by batch size and micro-batched from concurrent clients
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <ModelScorer.h>
+#include <pthread.h>
+#include <algorithm>
+#include <cstdio>
+
+static double nowSec() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static const int nclients = 8;
+static const int nrequests = 2000;      // per client
+
+struct Client {
+    ModelScorer* scorer;
+    int model;
+    std::vector<double> latency;
+};
+
+static void* clientMain(void* arg) {
+    Client* c = static_cast<Client*>(arg);
+    for (int i = 0; i < nrequests; i++) {
+        ModelScorer::Request req(c->model);
+        req.values.push_back(i % 7 - 3.0);
+        req.values.push_back(i % 5 - 2.0);
+        req.strings.push_back(i % 2 ? "a" : "b");
+        double t0 = nowSec();
+        c->scorer->submit(&req);
+        req.wait();
+        c->latency.push_back(nowSec() - t0);
+    }
+    return NULL;
+}
+
+struct Joiner {
+    pthread_t* threads;
+    ModelScorer* scorer;
+};
+
+static void* joinerMain(void* arg) {
+    Joiner* j = static_cast<Joiner*>(arg);
+    for (int i = 0; i < nclients; i++) {
+        pthread_join(j->threads[i], NULL);
+    }
+    j->scorer->shutdown();
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.parseEvalQ("set.seed(42); n <- 1000;"
+                 "d <- data.frame(x1=rnorm(n), x2=rnorm(n), g=sample(c('a','b'), n, TRUE));"
+                 "d$y <- 1 + 2*d$x1 - d$x2 + (d$g == 'a') + rnorm(n, sd=0.1);"
+                 "fit <- lm(y ~ x1 + x2 + g, data=d)");
+
+    ModelScorer::Schema schema;
+    schema.push_back(ModelScorer::Column("x1"));
+    schema.push_back(ModelScorer::Column("x2"));
+    schema.push_back(ModelScorer::Column("g", STRSXP));
+
+    ModelScorer scorer(R, 64, 1000);    // batches of up to 64, within 1ms
+    int model = scorer.loadModel("fit", schema);
+
+    // synchronous scoring, one call per batch
+    size_t sizes[] = { 1, 16, 256, 4096 };
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        std::vector<double> x1(n, 0.5), x2(n, -0.5), out;
+        std::vector<const char*> g(n, "a");
+        std::vector<const void*> cols;
+        cols.push_back(&x1[0]);
+        cols.push_back(&x2[0]);
+        cols.push_back(&g[0]);
+        int reps = std::max(10, static_cast<int>(20000 / n));
+        double t0 = nowSec();
+        for (int r = 0; r < reps; r++) {
+            scorer.score(model, cols, n, out);
+        }
+        double el = nowSec() - t0;
+        printf("batch %5lu: %9.1f rows/s, %8.1f usec per call\n",
+               (unsigned long) n, reps * n / el, 1e6 * el / reps);
+    }
+
+    // concurrent clients, micro-batched on this thread
+    pthread_t threads[nclients];
+    Client clients[nclients];
+    for (int i = 0; i < nclients; i++) {
+        clients[i].scorer = &scorer;
+        clients[i].model = model;
+        pthread_create(&threads[i], NULL, clientMain, &clients[i]);
+    }
+    Joiner joiner = { threads, &scorer };
+    pthread_t jt;
+    pthread_create(&jt, NULL, joinerMain, &joiner);
+    double t0 = nowSec();
+    scorer.serve();
+    double el = nowSec() - t0;
+    pthread_join(jt, NULL);
+
+    std::vector<double> lat;
+    for (int i = 0; i < nclients; i++) {
+        lat.insert(lat.end(), clients[i].latency.begin(), clients[i].latency.end());
+    }
+    std::sort(lat.begin(), lat.end());
+    printf("%d clients: %9.1f requests/s, latency p50 %.1f usec, p99 %.1f usec, max %.1f usec\n",
+           nclients, lat.size() / el, 1e6 * lat[lat.size() / 2],
+           1e6 * lat[lat.size() * 99 / 100], 1e6 * lat.back());
+
+    exit(0);
+}
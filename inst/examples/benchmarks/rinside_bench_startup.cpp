@@ -0,0 +1,80 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Startup cost per process: RInside construction with autoloads set up
+// eagerly or deferred, and the R-level delayedAssign() loop they replace
+//
+// Each measurement runs in a fresh child process as R can only be
+// initialized once per process.
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <sys/wait.h>
+#include <algorithm>
+#include <cstdio>
+
+static double nowUsec() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+enum Mode { Eager = 0, Deferred = 1, RLevel = 2 };
+static const char* modeNames[] = { "eager", "deferred", "rlevel" };
+
+// runs in the child: construction time, and the time of the first
+// lookup which misses everywhere (this sets up deferred autoloads)
+static void measure(int argc, char *argv[], Mode mode, double res[2]) {
+    RInside::Options options;
+    options.deferAutoloads = (mode != Eager);
+    double t0 = nowUsec();
+    RInside R(argc, argv, options);
+    res[0] = nowUsec() - t0;
+    if (mode == RLevel) {               // what autoloads() used to do, one closure call per name
+        t0 = nowUsec();
+        R.parseEvalQ("e <- new.env();"
+                     "for (p in getOption('defaultPackages'))"
+                     "  for (n in ls(paste('package:', p, sep='')))"
+                     "    do.call('delayedAssign', list(n, call('autoloader', name=n, package=p), .GlobalEnv, e))");
+        res[1] = nowUsec() - t0;
+    } else {
+        t0 = nowUsec();
+        R.parseEvalQ("invisible(exists('no.such.name.anywhere'))");
+        res[1] = nowUsec() - t0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const int runs = 10;
+    for (int m = Eager; m <= RLevel; m++) {
+        std::vector<double> ctor, first;
+        for (int r = 0; r < runs; r++) {
+            int fd[2];
+            if (pipe(fd) != 0) return 1;
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fd[0]);
+                double res[2];
+                measure(argc, argv, static_cast<Mode>(m), res);
+                if (write(fd[1], res, sizeof(res)) != sizeof(res)) _exit(1);
+                _exit(0);
+            }
+            close(fd[1]);
+            double res[2];
+            bool ok = read(fd[0], res, sizeof(res)) == sizeof(res);
+            close(fd[0]);
+            waitpid(pid, NULL, 0);
+            if (ok) {
+                ctor.push_back(res[0]);
+                first.push_back(res[1]);
+            }
+        }
+        if (ctor.empty()) continue;
+        std::sort(ctor.begin(), ctor.end());
+        std::sort(first.begin(), first.end());
+        printf("{\"mode\": \"%s\", \"runs\": %lu, \"construct_usec\": %.0f, \"%s_usec\": %.0f}\n",
+               modeNames[m], (unsigned long) ctor.size(), ctor[ctor.size() / 2],
+               m == RLevel ? "rlevel_autoloads" : "first_miss", first[first.size() / 2]);
+    }
+    return 0;
+}
@@ -9,11 +9,29 @@
 #include <QApplication>
 #include "qtdensity.h"
 
+#ifdef RINSIDE_CALLBACKS
+// keep the GUI responsive while R is busy: RInside calls this at most
+// every 'polling interval' msec during long evaluations; user input is
+// held back so that slots do not re-enter R mid-computation
+class QtEventCallbacks : public Callbacks {
+public:
+    virtual void ProcessEvents() {
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    }
+    virtual bool has_ProcessEvents() { return true; }
+};
+#endif
+
 int main(int argc, char *argv[])
 {
     RInside R(argc, argv);  		// create an embedded R instance
 
     QApplication app(argc, argv);
+#ifdef RINSIDE_CALLBACKS
+    QtEventCallbacks callbacks;
+    callbacks.setPollingInterval(16);  	// roughly one frame at 60Hz
+    R.set_callbacks(&callbacks);
+#endif
     QtDensity qtdensity(R);		// pass R inst. by reference
     return app.exec();
 }
@@ -7,14 +7,12 @@
 
 #include "qtdensity.h"
 
-QtDensity::QtDensity(RInside & R) : m_R(R)
+QtDensity::QtDensity(RInside & R) : m_R(R), m_device(6, 6, 10)
 {
     m_bw = 100;                 // initial bandwidth, will be scaled by 100 so 1.0
     m_kernel = 0;               // initial kernel: gaussian
     m_cmd = "c(rnorm(100,0,1), rnorm(50,5,1))"; // simple mixture
-    m_R["bw"] = m_bw;           // pass bandwidth to R, and have R compute a temp.file name
-    m_tempfile = QString::fromStdString(Rcpp::as<std::string>(m_R.parseEval("tfile <- tempfile()")));
-    m_svgfile = QString::fromStdString(Rcpp::as<std::string>(m_R.parseEval("sfile <- tempfile()")));
+    m_R["bw"] = m_bw;           // pass bandwidth to R
     setupDisplay();
 }
 
@@ -95,13 +93,13 @@ void QtDensity::plot(void) {
     const char *kernelstrings[] = { "gaussian", "epanechnikov", "rectangular", "triangular", "cosine" };
     m_R["bw"] = m_bw;
     m_R["kernel"] = kernelstrings[m_kernel]; // that passes the string to R
-    std::string cmd0 = "svg(width=6,height=6,pointsize=10,filename=tfile); ";
     std::string cmd1 = "plot(density(y, bw=bw/100, kernel=kernel), xlim=range(y)+c(-2,2), main=\"Kernel: ";
-    std::string cmd2 = "\"); points(y, rep(0, length(y)), pch=16, col=rgb(0,0,0,1/4));  dev.off()";
-    std::string cmd = cmd0 + cmd1 + kernelstrings[m_kernel] + cmd2; // stick the selected kernel in the middle
+    std::string cmd2 = "\"); points(y, rep(0, length(y)), pch=16, col=rgb(0,0,0,1/4))";
+    std::string cmd = cmd1 + kernelstrings[m_kernel] + cmd2; // stick the selected kernel in the middle
+    m_device.activate();        // plots go to memory rather than to a file
     m_R.parseEvalQ(cmd);
-    filterFile();           	// we need to simplify the svg file for display by Qt 
-    m_svg->load(m_svgfile);
+    m_device.flush();
+    m_svg->load(QByteArray(m_device.svg().data(), m_device.svg().size()));
 }
 
 void QtDensity::getBandwidth(int bw) {
@@ -127,25 +125,3 @@ void QtDensity::runRandomDataCmd(void) {
     m_R.parseEvalQNT(cmd);
     plot();                     // after each random draw, update plot with estimate
 }
-
-void QtDensity::filterFile() {
-    // cairoDevice creates richer SVG than Qt can display
-    // but per Michaele Lawrence, a simple trick is to s/symbol/g/ which we do here
-    QFile infile(m_tempfile);
-    infile.open(QFile::ReadOnly);
-    QFile outfile(m_svgfile);
-    outfile.open(QFile::WriteOnly | QFile::Truncate);
-    
-    QTextStream in(&infile);
-    QTextStream out(&outfile);
-    QRegExp rx1("<symbol"); 
-    QRegExp rx2("</symbol");    
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        line.replace(rx1, "<g"); // so '<symbol' becomes '<g ...'
-        line.replace(rx2, "</g");// and '</symbol becomes '</g'
-        out << line << "\n";
-    }
-    infile.close();
-    outfile.close();
-}
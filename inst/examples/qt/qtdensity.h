@@ -22,7 +22,6 @@
 #include <QSlider>
 #include <QSpinBox>
 #include <QLabel>
-#include <QTemporaryFile>
 #include <QSvgWidget>
 
 class QtDensity : public QMainWindow
@@ -41,12 +40,10 @@ private slots:
 private:
     void setupDisplay(void);    // standard GUI boilderplate of arranging things
     void plot(void);            // run a density plot in R and update the
-    void filterFile(void);      // modify the richer SVG produced by R
 
     QSvgWidget *m_svg;          // the SVG device
     RInside & m_R;              // reference to the R instance passed to constructor
-    QString m_tempfile;         // name of file used by R for plots
-    QString m_svgfile;          // another temp file, this time from Qt
+    SvgDevice m_device;         // R graphics device drawing into memory
     int m_bw, m_kernel;         // parameters used to estimate the density
     QString m_cmd;              // random draw command string
 };
@@ -0,0 +1,48 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4;  tab-width: 8; -*-
+//
+// Simple example showing how to take R's console output in large pieces,
+// written out by a thread of its own, instead of fragment by fragment
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+//
+// GPL'ed
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+#if !defined(RINSIDE_CALLBACKS)
+int main(int argc, char *argv[]) {
+    printf("This example requires RInside to be compiled and installed with RINSIDE_CALLBACKS defined\nSee inst/include/RInsideConfig.h\n");
+    exit(0);
+}
+#else
+
+class CountingSink : public FileConsoleSink {   // to stdout/stderr, and counts the writes
+public:
+    CountingSink() : writes(0) {}
+    virtual void write(const char* data, size_t len, int oType) {
+        writes++;
+        FileConsoleSink::write(data, len, oType);
+    }
+    int writes;
+};
+
+int main(int argc, char *argv[]) {
+    CountingSink sink;
+    BufferedConsole console(sink, 1 << 20);     // 1mb per stream
+    console.startWriter();
+
+    Callbacks *callbacks = new Callbacks();
+    callbacks->setConsoleSink(&console);
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.set_callbacks( callbacks );
+
+    R.parseEvalQ("print(matrix(rnorm(20000), ncol = 4))");
+    R.parseEvalQ("message('done printing')");
+    console.flush();
+
+    std::cerr << "R's output took " << sink.writes << " writes" << std::endl;
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,39 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4;  tab-width: 8; -*-
+//
+// Simple example showing how to feed a large generated script through
+// R's REPL, read piece by piece as R asks for it
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+//
+// GPL'ed
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+#if !defined(RINSIDE_CALLBACKS)
+int main(int argc, char *argv[]) {
+    printf("This example requires RInside to be compiled and installed with RINSIDE_CALLBACKS defined\nSee inst/include/RInsideConfig.h\n");
+    exit(0);
+}
+#else
+
+int main(int argc, char *argv[]) {
+    std::ostringstream script;          // a few mb of R code, with lines longer than R's buffer
+    script << "x <- c(" << 0;
+    for (int i = 1; i < 200000; i++) script << "," << i;
+    script << ")\n";
+    for (int i = 0; i < 10000; i++) script << "x[" << i + 1 << "] <- x[" << i + 1 << "] * 2\n";
+    script << "cat('sum:', sum(x), '\\n')\n";
+    std::string code = script.str();
+
+    MemoryInputSource input(code.data(), code.size());
+    Callbacks *callbacks = new Callbacks();
+    callbacks->setInputSource(&input);
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.set_callbacks( callbacks );
+    R.repl();                           // returns at the end of the input
+
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,46 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4;  tab-width: 8; -*-
+//
+// Simple example showing how to drive R's REPL from a host event loop,
+// a few expressions at a time, as input trickles in
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+//
+// GPL'ed
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+#if !defined(RINSIDE_CALLBACKS)
+int main(int argc, char *argv[]) {
+    printf("This example requires RInside to be compiled and installed with RINSIDE_CALLBACKS defined\nSee inst/include/RInsideConfig.h\n");
+    exit(0);
+}
+#else
+
+int main(int argc, char *argv[]) {
+    // what a client might send, in pieces that do not respect line ends
+    const char* packets[] = { "x <- 1:10\ny <- cum", "sum(x)\nprint(", "tail(y, 3))\nf <- function(a) {\n",
+                              "  a * 2\n}\n", "print(f(y[10]))\n", NULL };
+
+    FeedInputSource input;
+    Callbacks *callbacks = new Callbacks();
+    callbacks->setInputSource(&input);
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.set_callbacks( callbacks );
+
+    for (int i = 0; ; ) {
+        RInside::ReplStatus status = R.replStep(2, 10000);  // two expressions or 10ms, whichever first
+        if (status == RInside::ReplEnd) break;
+        if (status == RInside::ReplNeedInput) {     // a real host would go back to its poll() here
+            if (packets[i] != NULL) {
+                input.feed(packets[i], strlen(packets[i]));
+                i++;
+            } else {
+                input.close();
+            }
+        }
+    }
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,51 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4;  tab-width: 8; -*-
+//
+// Simple example checking that console output still reaches the terminal
+// when the callbacks do not write the console themselves, after output
+// was captured and while GC telemetry follows R's reports
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+//
+// GPL'ed
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+#if !defined(RINSIDE_CALLBACKS)
+int main(int argc, char *argv[]) {
+    printf("This example requires RInside to be compiled and installed with RINSIDE_CALLBACKS defined\nSee inst/include/RInsideConfig.h\n");
+    exit(0);
+}
+#else
+
+class BusyCallbacks : public Callbacks {     // knows nothing of the console
+public:
+    BusyCallbacks() : busy(0) {} ;
+    virtual void Busy( bool is_busy ) { if (is_busy) busy++ ; } ;
+    virtual bool has_Busy() { return true ; } ;
+    int busy ;
+} ;
+
+int main(int argc, char *argv[]) {
+    RInside R(argc, argv);              // create an embedded R instance
+    BusyCallbacks *callbacks = new BusyCallbacks();
+    R.set_callbacks( callbacks );
+
+    std::string out = R.parseEvalCapture("print(1:3)");
+    if (out.find("[1] 1 2 3") == std::string::npos) {
+        printf("FAILED: captured '%s'\n", out.c_str());
+        exit(1);
+    }
+    R.parseEvalQ("cat('after capture: on stdout\\n')");
+    R.parseEvalQ("message('after capture: on stderr')");
+
+    R.setGcTelemetry(true);
+    R.parseEvalQ("invisible(gc())");
+    R.parseEvalQ("cat('with telemetry: on stdout\\n')");
+    R.parseEvalQ("message('with telemetry: on stderr')");
+    R.setGcTelemetry(false);
+
+    printf("Expected the four lines above, and %d collection(s) recorded\n", (int)R.gcStats().collections);
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4;  tab-width: 8; -*-
+//
+// Simple example feeding lines with errors through replStep(): a failing
+// call, a syntax error and an incomplete expression at the end of input
+// are shown, and the session as well as what the host protected live on
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+//
+// GPL'ed
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+#if !defined(RINSIDE_CALLBACKS)
+int main(int argc, char *argv[]) {
+    printf("This example requires RInside to be compiled and installed with RINSIDE_CALLBACKS defined\nSee inst/include/RInsideConfig.h\n");
+    exit(0);
+}
+#else
+
+int main(int argc, char *argv[]) {
+    const char* lines[] = { "x <- 1\n", "stop('boom')\n", "1 +* 2\n", "f <- function() stop('deeper'); f()\n",
+                            "invisible(gc()); x + 1\n", "y <- c(1,\n", NULL };
+
+    FeedInputSource input;
+    Callbacks *callbacks = new Callbacks();
+    callbacks->setInputSource(&input);
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.set_callbacks( callbacks );
+
+    SEXP kept = PROTECT(Rf_mkString("still here"));     // the host's own, across the steps
+
+    for (int i = 0; ; ) {
+        RInside::ReplStatus status = R.replStep(1);
+        if (status == RInside::ReplEnd) break;
+        if (status == RInside::ReplNeedInput) {
+            if (lines[i] != NULL) {
+                input.feed(lines[i], strlen(lines[i]));
+                i++;
+            } else {
+                input.close();
+            }
+        }
+    }
+
+    R.parseEvalQ("invisible(gc())");
+    std::cout << CHAR(STRING_ELT(kept, 0)) << ", x is " << Rcpp::as<double>(R.parseEval("x")) << std::endl;
+    UNPROTECT(1);
+    exit(0);
+}
+
+#endif
@@ -0,0 +1,56 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of reading an R result from several threads at once
+// through a pinned, immutable snapshot
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <pthread.h>
+
+struct Job {
+    RInsideSnapshot data;               // each thread holds its own copy of the handle
+    size_t from, to;
+    double sum;
+};
+
+static void* partialSum(void* arg) {
+    Job* job = static_cast<Job*>(arg);
+    const double* x = job->data.real(); // no R calls, no locking, no copy
+    job->sum = 0.0;
+    for (size_t i = job->from; i < job->to; i++) {
+        job->sum += x[i];
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+
+    R.parseEvalQ("x <- rnorm(1e6)");
+    RInsideSnapshot snap = R.snapshot("x"); // taken on the R thread
+
+    const int nthreads = 4;
+    pthread_t threads[nthreads];
+    Job jobs[nthreads];
+    size_t chunk = snap.size() / nthreads;
+    for (int i = 0; i < nthreads; i++) {
+        jobs[i].data = snap;
+        jobs[i].from = i * chunk;
+        jobs[i].to = (i == nthreads - 1) ? snap.size() : (i + 1) * chunk;
+        pthread_create(&threads[i], NULL, partialSum, &jobs[i]);
+    }
+    double total = 0.0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        total += jobs[i].sum;
+        jobs[i].data = RInsideSnapshot(); // drop the thread's reference
+    }
+
+    R.parseEvalQ("x[1] <- 0");          // R duplicates, the snapshot stays unchanged
+    double check = R.parseEval("sum(x)");
+    std::cout << "Threads summed " << total << ", R now has " << check << std::endl;
+
+    exit(0);
+}
@@ -0,0 +1,56 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of looking at per-call latency next to R's garbage
+// collections, of keeping collections out of a latency-critical section,
+// and of capping what a single call may allocate
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.setGcTelemetry(true);             // follow R's collections from here on
+    R.setEvalCounters(true);            // and what the CPU and OS count per call
+
+    for (int i = 0; i < 200; i++) {
+        R.parseEvalQ("x <- rnorm(1e5); m <- summary(lm(x ~ seq_along(x)))");
+    }
+
+    {
+        RInside::GcScope quiet(R, 256*1024*1024); // up to 256mb of vectors without a collection
+        R.parseEvalQ("y <- cumsum(rnorm(1e6))");
+    }
+    R.gc(false);                        // and tidy up the young generation afterwards
+
+    R.setEvalBudget(512*1024*1024);     // no single call may grow the heap by more than 512mb
+    try {
+        R.parseEvalQ("z <- numeric(1e10)");     // 80gb
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;    // rather than the OOM killer stepping in
+    }
+    R.parseEvalQ("z <- numeric(1e6)");
+    std::cout << "last call grew the heap by " << R.lastEvalMemory().bytes / 1048576 << " mb" << std::endl;
+    R.setEvalBudget(0);
+    R.parseEvalQ("z <- numeric(8e7)");  // 640mb, over the budget there was, fine without one
+    R.parseEvalQ("rm(z)");
+
+    EvalStats es = R.evalStats();
+    GcStats gs = R.gcStats();
+    std::cout << "calls: " << es.calls << ", p50 " << es.latencyUsec.quantile(0.50)
+              << " us, p99 " << es.latencyUsec.quantile(0.99) << " us" << std::endl;
+    if (es.hardwareCounted) {
+        std::cout << "instructions per cycle: " << es.ipc() << ", cache misses p50 "
+                  << es.cacheMisses.quantile(0.50) << std::endl;
+    }
+    std::cout << "on cpu: " << 100 * es.cpuUsec.sum() / es.latencyUsec.sum() << "%, context switches "
+              << es.contextSwitches.sum() << std::endl;
+    std::cout << "collections: " << gs.collections << " (" << gs.byLevel[0] << "/"
+              << gs.byLevel[1] << "/" << gs.byLevel[2] << " by level), pause p99 "
+              << gs.pauseUsec.quantile(0.99) << " us, max " << gs.pauseUsec.max() << " us" << std::endl;
+    std::cout << "heap: " << gs.vectorBytes / 1048576 << " of " << gs.vectorHeapBytes / 1048576
+              << " mb of vectors in use" << std::endl;
+
+    exit(0);
+}
@@ -0,0 +1,23 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of getting what R prints for one evaluation, without
+// capture.output()
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+
+    std::string txt = R.parseEvalCapture("fit <- lm(dist ~ speed, data = cars); print(summary(fit))");
+    std::cout << "summary() printed " << txt.size() << " characters:\n" << txt;
+
+    SEXP ans;                           // messages too, with the value of the last expression
+    std::string all;
+    R.parseEvalCapture("message('fitting'); coef(fit)", ans, all, true);
+    std::cout << "captured: " << all;
+
+    exit(0);
+}
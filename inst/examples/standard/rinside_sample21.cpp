@@ -0,0 +1,33 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of receiving R's messages and warnings as C++ events
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+class PrintSink : public ConditionSink {
+public:
+    virtual void condition(const RCondition& cond) {
+        static const char* types[] = { "message", "warning", "error" };
+        std::cout << "[" << types[cond.type] << "] " << cond.classes.front()
+                  << ": " << cond.message;
+        if (!cond.call.empty()) std::cout << " (in " << cond.call << ")";
+        std::cout << std::endl;
+    }
+};
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    PrintSink sink;
+
+    R.setConditionSink(&sink);
+    R.parseEvalQ("message('starting'); x <- as.integer('a'); y <- log(-1)");
+    R.parseEvalQ("f <- function(n) { if (n > 2) warning('n is large'); n }; f(5)");
+
+    R.setConditionSink(NULL);           // back to R's own reporting
+    R.parseEvalQ("message('not forwarded')");
+
+    exit(0);
+}
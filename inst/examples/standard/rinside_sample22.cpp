@@ -0,0 +1,36 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of running an R script file statement by statement
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <fstream>
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+
+    const char* path = argc > 1 ? argv[1] : "generated.R";
+    if (argc == 1) {                    // write a generated script to run
+        std::ofstream out(path);
+        for (int i = 0; i < 1000; i++) {
+            out << "x" << i << " <- sum(seq_len(" << i << "))\n";
+        }
+        out << "total <- sum(sapply(ls(pattern = '^x'),\n"
+            << "                    function(n) get(n)))\n"
+            << "stop('this line fails')\n";
+    }
+
+    int failed = R.parseEvalFile(path, false);     // keep going past errors
+    std::cout << failed << " statement(s) failed, total is "
+              << Rcpp::as<double>(R["total"]) << std::endl;
+
+    try {
+        R.parseEvalFile(path);          // stop at the first error
+    } catch (std::exception& ex) {
+        std::cout << "stopped: " << ex.what() << std::endl;
+    }
+
+    exit(0);
+}
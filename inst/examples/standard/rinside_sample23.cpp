@@ -0,0 +1,30 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of plotting into memory, one SVG document per page
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+class PageCounter : public GraphicsSink {
+public:
+    virtual void page(const char* svg, size_t len, int number) {
+        std::cout << "page " << number << ": " << len << " bytes of SVG" << std::endl;
+    }
+};
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    PageCounter counter;
+    SvgDevice dev(6, 4, 10, &counter);  // now R's current device
+
+    R.parseEvalQ("x <- rnorm(500); hist(x); plot(density(x))");
+    dev.flush();                        // the page still being drawn
+
+    R.parseEvalQ("plot(ecdf(x)); dev.off()");
+    std::cout << dev.pages() << " pages, last one starts with\n"
+              << dev.svg().substr(0, 160) << std::endl;
+
+    exit(0);
+}
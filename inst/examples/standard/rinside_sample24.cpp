@@ -0,0 +1,28 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of a private temporary directory kept in memory
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+int main(int argc, char *argv[]) {
+
+    RInside::Options options;
+    options.tempBase = "/dev/shm";      // a tmpfs on most Linux systems
+    options.tempLimit = 64 * 1024 * 1024;
+    RInside R(argc, argv, options);     // create an embedded R instance
+
+    std::cout << "tempdir() is " << R.tempDir() << std::endl;
+    R.parseEvalQ("for (i in 1:100) saveRDS(rnorm(1e4), tempfile(fileext = '.rds'))");
+    std::cout << R.tempBytes() << " bytes in use" << std::endl;
+
+    R.parseEvalQ("writeBin(raw(1e8), tempfile())");    // more than the limit allows
+    R.parseEvalQ("Sys.sleep(1)");       // the directory is measured at most once a second
+    if (R.tempExceeded()) {
+        std::cout << "over the limit with " << R.tempBytes() << " bytes" << std::endl;
+        R.parseEvalQ("unlink(list.files(tempdir(), full.names = TRUE))");
+    }
+
+    exit(0);                            // the directory goes, even without ~RInside()
+}
@@ -0,0 +1,30 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of a timeline of host and R work, for chrome://tracing
+// or https://ui.perfetto.dev
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <fstream>
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    RInsideTrace::enable();
+    RInsideTrace::setThreadName("R");
+
+    for (int i = 0; i < 20; i++) {
+        RInsideTraceSpan span("host", "request");
+        std::vector<double> x(1000, i);
+        R.assign(x, "x");
+        double m = R.parseEval("mean(x + rnorm(length(x)))");
+        (void) m;
+    }
+
+    std::ofstream out("rinside_trace.json");
+    out << RInsideTrace::chromeJson();
+    std::cout << "trace written to rinside_trace.json" << std::endl;
+
+    exit(0);
+}
@@ -0,0 +1,27 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of profiling R code from C++, without Rprof() files
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <cstdio>
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+
+    R.parseEvalQ("fit <- function(n) { d <- data.frame(x = rnorm(n), y = rnorm(n)); lm(y ~ x, d) };"
+                 "boot <- function(k) replicate(k, coef(fit(5000))[2])");
+    RInsideProfile p = R.profile("b <- boot(200)", 0.005, true);
+
+    printf("%ld samples of %.3f s, %.1f MB allocated\n", p.samples, p.interval, p.bytes / 1048576);
+    printf("%-28s %8s %8s %10s\n", "function", "self s", "total s", "total MB");
+    for (size_t i = 0; i < p.functions.size() && i < 15; i++) {
+        const RInsideProfileEntry& e = p.functions[i];
+        printf("%-28s %8.3f %8.3f %10.1f\n", e.name.c_str(), p.seconds(e.selfSamples),
+               p.seconds(e.totalSamples), e.totalBytes / 1048576);
+    }
+
+    exit(0);
+}
@@ -0,0 +1,32 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of RInside metrics in the Prometheus text format, as a
+// host would serve them from its /metrics endpoint
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    R.setGcTelemetry(true);             // adds collections, pauses and heap sizes
+
+    Metrics::Counter& requests = R.metrics().counter("myservice_requests_total",
+                                                     "Requests served.", "endpoint=\"score\"");
+    for (int i = 0; i < 100; i++) {
+        requests.inc();
+        R.assign(std::vector<double>(1000, i), "x");
+        double s = R.parseEval("sum(sqrt(x))");
+        (void) s;
+    }
+    try {
+        R.parseEvalQ("stop('failing on purpose')");
+    } catch (std::exception& ex) {
+        // counted as an evaluation error
+    }
+
+    std::cout << R.renderPrometheus();
+
+    exit(0);
+}
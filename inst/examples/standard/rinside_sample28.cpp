@@ -0,0 +1,42 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of a work queue with priority classes, and of a budget
+// letting batch work through between interactive requests
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+#include <WorkQueue.h>
+
+static std::vector<WorkQueue::EvalJob*> jobs;
+
+static void dispatch(RInside& R, WorkQueue& queue) {
+    const char* names[] = { "i1", "i2", "i3", "i4", "b1", "b2" };
+    R.parseEvalQ("order <- character()");
+    for (int i = 0; i < 6; i++) {
+        jobs.push_back(new WorkQueue::EvalJob(std::string("order <- c(order, '") + names[i] + "')"));
+        queue.submit(jobs.back(), i < 4 ? WorkQueue::Interactive : WorkQueue::Batch);
+    }
+    queue.runPending();
+    R.parseEvalQ("cat(order, '\\n')");
+}
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+    WorkQueue queue(R);
+
+    dispatch(R, queue);                 // i1 i2 i3 i4 b1 b2: by class
+    queue.setBudget(WorkQueue::Interactive, 2);
+    dispatch(R, queue);                 // i1 i2 b1 i3 i4 b2: batch gets a turn after two
+    queue.setBudget(WorkQueue::Interactive, -1);
+    queue.setBudget(WorkQueue::Batch, 0);
+    dispatch(R, queue);                 // i1 i2 i3 i4: batch held back
+    queue.setBudget(WorkQueue::Batch, -1);
+    queue.runPending();                 // and now let through
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        delete jobs[i];
+    }
+    exit(0);
+}
@@ -0,0 +1,24 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; tab-width: 8; -*-
+//
+// Simple example of recycling one embedded R for a series of tenants:
+// reset() returns to the state right after construction in between
+//
+// Copyright (C) 2026 Dirk Eddelbuettel and Romain Francois
+
+#include <RInside.h>                    // for the embedded R via RInside
+
+int main(int argc, char *argv[]) {
+
+    RInside R(argc, argv);              // create an embedded R instance
+
+    const char* tenants[] = { "alice", "bob", NULL };
+    for (int i = 0; tenants[i] != NULL; i++) {
+        R["tenant"] = tenants[i];
+        R.parseEvalQ("secret <- paste('data of', tenant); options(digits = 3); attach(list(z = 1), name = 'extra')");
+        R.parseEvalQ("cat(tenant, 'sees:', ls(), '| digits', getOption('digits'), '| extra attached', 'extra' %in% search(), '\\n')");
+        R.reset();                      // nothing of this tenant is left for the next one
+    }
+    R.parseEvalQ("cat('after reset:', length(ls()), 'objects, digits', getOption('digits'), '\\n')");
+
+    exit(0);
+}
@@ -33,6 +33,7 @@ using namespace Wt;
 class DensityApp : public WApplication {
 public:
     DensityApp(const WEnvironment& env, RInside & R);
+    ~DensityApp();
 
 private:
     WLineEdit *codeEdit_;	// to edit the RNG draw expression
@@ -46,6 +47,7 @@ private:
     void reportEdit();		// called when RNG expression edited
     void reportSpinner();	// called when bandwidth changed
     void plot();		// to call R for new plot
+    RInside::Session& session();	// this user's variables in R
     
     enum Kernel { Gaussian     = 0, Epanechnikov = 1, Rectangular  = 2,
 		  Triangular   = 3, Cosine       = 4 };
@@ -70,7 +72,7 @@ DensityApp::DensityApp(const WEnvironment& env, RInside & R) : WApplication(env)
     new WText(WString::tr("overview"), root());
 
     std::string tfcmd = "tfile <- tempfile(pattern=\"img\", tmpdir=\"/tmp\", fileext=\".png\")";	
-    tempfile_ = Rcpp::as<std::string>(R_.parseEval(tfcmd));  	// assign to 'tfile' in R, and report back
+    tempfile_ = Rcpp::as<std::string>(session().parseEval(tfcmd));  // assign to 'tfile' in R, and report back
     bw_ = 100; 
     kernel_ = 0;						// parameters used to estimate the density
     cmd_ = "c(rnorm(100,0,1), rnorm(50,5,1))";			// random draw command string
@@ -148,6 +150,18 @@ DensityApp::DensityApp(const WEnvironment& env, RInside & R) : WApplication(env)
     plot();							// and draw a new density plot
 }
 
+DensityApp::~DensityApp() {
+    R_.dropSession(sessionId());
+}
+
+// Every user gets a session, so concurrent users do not overwrite each
+// other's 'y', 'bw' and 'tfile'.  It is looked up on each use as idle
+// sessions may be evicted when memory runs short; plot() assigns all of
+// its inputs so an evicted session is simply recreated.
+RInside::Session& DensityApp::session() {
+    return R_.session(sessionId());
+}
+
 void DensityApp::reportButton() {
     kernel_ = group_->checkedId(); 				// get id of selected kernel 
     plot();
@@ -156,8 +170,9 @@ void DensityApp::reportButton() {
 void DensityApp::reportEdit() {
     cmd_ = codeEdit_->text().toUTF8();	// get text written in box, as UTF-8, assigned to string
     std::string rng = "y2 <- " + cmd_ + "; y <- y2";
-    R_.parseEvalQNT(rng);			// evaluates expression, assigns to 'y'
-    Yvec_ = R_["y"];			// cache the y vector
+    RInside::Session& S = session();
+    S.parseEvalQNT(rng);			// evaluates expression, assigns to 'y'
+    Yvec_ = S["y"];				// cache the y vector
     plot();
 }
 
@@ -169,14 +184,15 @@ void DensityApp::reportSpinner() {
 void DensityApp::plot() {
     const char *kernelstr[] = { "gaussian", "epanechnikov", "rectangular", "triangular", "cosine" };
     greeting_->setText("Starting R call");
-    R_["tfile"]  = tempfile_;
-    R_["bw"]     = bw_;
-    R_["kernel"] = kernelstr[kernel_]; 			// passes the string to R
-    R_["y"]      = Yvec_;
+    RInside::Session& S = session();
+    S["tfile"]  = tempfile_;
+    S["bw"]     = bw_;
+    S["kernel"] = kernelstr[kernel_]; 			// passes the string to R
+    S["y"]      = Yvec_;
     std::string cmd0 = "png(filename=tfile,width=600,height=400); plot(density(y, bw=bw/100, kernel=kernel), xlim=range(y)+c(-2,2), main=\"Kernel: ";
     std::string cmd1 = "\"); points(y, rep(0, length(y)), pch=16, col=rgb(0,0,0,1/4));  dev.off()";
     std::string cmd = cmd0 + kernelstr[kernel_] + cmd1; // stick the selected kernel in the middle
-    R_.parseEvalQ(cmd);				     	// evaluate command -- generates new density plot
+    S.parseEvalQ(cmd);				     	// evaluate command -- generates new density plot
     imgfile_->setChanged();				// important: tells consumer that image has changed, forces refresh
     greeting_->setText("Finished request from " + this->environment().clientAddress() + " using " + this->environment().userAgent()) ;
 }
@@ -194,6 +210,7 @@ WApplication *createApplication(const WEnvironment& env) {
 int main(int argc, char **argv) {
 
     RInside R(argc, argv);              // create the one embedded R instance 
+    R.setSessionLimit(64*1024*1024);    // evict idle user sessions beyond 64mb of R objects
 
     // Your main method may set up some shared resources, but should then
     // start the server application (FastCGI or httpd) that starts listening
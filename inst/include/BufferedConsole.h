@@ -0,0 +1,106 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// BufferedConsole.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_BUFFEREDCONSOLE_H
+#define RINSIDE_BUFFEREDCONSOLE_H
+
+#include <RInsideCommon.h>
+#include <Mutex.h>
+
+// Receives R's console output as it is written, without copies: data is
+// only valid during the call.  oType is 0 for output, 1 for messages,
+// warnings and errors.
+class ConsoleSink {
+public:
+    virtual ~ConsoleSink() {}
+    virtual void write(const char* data, size_t len, int oType) = 0;
+    virtual void flush() {}
+};
+
+class FileConsoleSink : public ConsoleSink {   // to stdout and stderr, or other files
+public:
+    FileConsoleSink(FILE* out = stdout, FILE* err = stderr) : out_m(out), err_m(err) {}
+    virtual void write(const char* data, size_t len, int oType) {
+        fwrite(data, sizeof(char), len, oType ? err_m : out_m);
+    }
+    virtual void flush() { fflush(out_m); fflush(err_m); }
+private:
+    FILE* out_m;
+    FILE* err_m;
+};
+
+// Coalesces the many small fragments R writes into larger writes to
+// another sink.  Each stream has its own ring buffer, flushed when it
+// holds flushSize bytes, on a newline if asked for, when its oldest byte
+// is older than the flush interval (noticed on the next write unless the
+// writer thread runs), or on flush().  Output of one stream
+// is delivered before the other stream gets written to, so the two stay in
+// order.  With startWriter() a background thread delivers, and R only ever
+// waits on a slow sink when a ring is full.
+class BufferedConsole : public ConsoleSink {
+public:
+    explicit BufferedConsole(ConsoleSink& target, size_t capacity = 65536);
+    ~BufferedConsole();                 // flushes and stops the writer
+
+    void setFlushSize(size_t bytes)     { flush_size_m = bytes; }   // default: half the capacity
+    void setFlushOnNewline(bool on)     { newline_m = on; }         // default: off
+    void setFlushInterval(long usec)    { interval_m = usec; }      // default: 50ms, 0 for none
+
+    void startWriter();                 // deliver from a thread of our own from now on
+    void stopWriter();
+
+    virtual void write(const char* data, size_t len, int oType);
+    virtual void flush();
+
+private:
+    struct Ring {
+        std::vector<char> data;
+        size_t head;                    // first byte not yet delivered
+        size_t used;
+        double since;                   // when the oldest byte was written
+        bool due;                       // flush policy says deliver
+    };
+
+    ConsoleSink& target_m;
+    Ring rings_m[2];
+    size_t flush_size_m;
+    bool newline_m;
+    long interval_m;
+    int last_m;                         // stream written to last
+
+    RInsideMutex mutex_m;
+    RInsideCondition wake_m;            // to the writer: something is due
+    RInsideCondition space_m;           // from the writer: something was delivered
+    pthread_t writer_m;
+    bool threaded_m;
+    bool stop_m;
+
+    void append(Ring& ring, const char* data, size_t len);
+    void drain(int oType);              // with the mutex held, released while writing
+    static void* writerMain(void* self);
+    void writerLoop();
+
+    BufferedConsole(const BufferedConsole&);
+    BufferedConsole& operator=(const BufferedConsole&);
+};
+
+#endif
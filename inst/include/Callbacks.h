@@ -23,13 +23,16 @@
 #define RINSIDE_CALLBACKS_H
 
 #include <RInsideCommon.h>
+#include <BufferedConsole.h>
+#include <InputSource.h>
 
 #ifdef RINSIDE_CALLBACKS
 
 class Callbacks {
 public:
 	
-	Callbacks() : R_is_busy(false), buffer() {} ;
+	Callbacks() : R_is_busy(false), buffer(), poll_usec(20000), in_events(false), console_sink(0),
+		input_source(0), input_buf(), input_pos(0), input_end(0), input_nl(0), input_room(4094), input_eof(false) { last_poll.tv_sec = 0; last_poll.tv_usec = 0; } ;
 	virtual ~Callbacks(){} ;
 	
 	virtual void ShowMessage(const char* message) {} ;
@@ -40,10 +43,13 @@ public:
 	virtual void ResetConsole() {};
 	virtual void CleanerrConsole(){} ;
 	virtual void Busy( bool is_busy ) {} ;
+	virtual void ProcessEvents() {} ;
 	
 	void Busy_( int which ) ;
+	void ProcessEvents_() ;
 	int ReadConsole_( const char* prompt, unsigned char* buf, int len, int addtohistory ) ;
 	void WriteConsole_( const char* buf, int len, int oType ) ;
+	void FlushConsole_() ;
 	
 	// TODO: ShowFiles
 	// TODO: ChooseFile
@@ -58,10 +64,44 @@ public:
 	virtual bool has_CleanerrConsole() { return false ; } ;
 	virtual bool has_Busy() { return false ; } ;
 	virtual bool has_FlushConsole(){ return false; } ;
+	virtual bool has_ProcessEvents() { return false ; } ;
+
+	// minimal interval between two calls of ProcessEvents() while R is busy;
+	// needs to be set before RInside::set_callbacks() to affect R's own waits
+	void setPollingInterval( int msec ) { poll_usec = (msec > 0) ? msec * 1000 : 0 ; } ;
+	int getPollingInterval() const { return poll_usec / 1000 ; } ;
+
+	// alternative to WriteConsole(): console output goes to the sink as is,
+	// without a copy into a std::string and a virtual call per fragment;
+	// a BufferedConsole coalesces the fragments.  Set before set_callbacks()
+	void setConsoleSink( ConsoleSink* sink ) { console_sink = sink ; } ;
+	ConsoleSink* getConsoleSink() const { return console_sink ; } ;
+	bool writesConsole() { return console_sink || has_WriteConsole() ; } ;
+
+	// alternative to ReadConsole(): R pulls its input from the source in
+	// chunks of its buffer size, whole lines where they fit, keeping the rest
+	// for the next read; the end of the source ends repl()
+	void setInputSource( InputSource* source ) ;
+	InputSource* getInputSource() const { return input_source ; } ;
+	bool readsConsole() { return input_source || has_ReadConsole() ; } ;
+	bool inputReady() ;					// R's next read from the source would not block
 	
 private:
 	bool R_is_busy ;
 	std::string buffer ;
+	int poll_usec ;
+	struct timeval last_poll ;
+	bool in_events ;
+	ConsoleSink* console_sink ;
+	InputSource* input_source ;
+	std::vector<char> input_buf ;		// read from the source, not yet given to R
+	size_t input_pos, input_end ;
+	size_t input_nl ;					// just past the last newline read
+	size_t input_room ;					// bytes of a line R's buffer takes at once
+	bool input_eof ;
+	void fillInput_( bool wait ) ;
+	int ReadInput_( unsigned char* buf, int len ) ;
+	friend class RInside ;
 	
 } ;                                       
 
@@ -0,0 +1,44 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// ConditionSink.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_CONDITIONSINK_H
+#define RINSIDE_CONDITIONSINK_H
+
+#include <string>
+#include <vector>
+
+// a message, warning or error signalled by R code, see RInside::setConditionSink()
+struct RCondition {
+    enum Type { Message, Warning, Error };
+    Type type;
+    std::vector<std::string> classes;   // as class(cond), eg "simpleWarning" "warning" "condition"
+    std::string message;                // conditionMessage(cond)
+    std::string call;                   // deparsed conditionCall(cond), empty if none
+};
+
+class ConditionSink {
+public:
+    virtual ~ConditionSink() {}
+    virtual void condition(const RCondition& cond) = 0;    // on the R thread, must not throw
+};
+
+#endif
@@ -0,0 +1,64 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Counters.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_COUNTERS_H
+#define RINSIDE_COUNTERS_H
+
+// what the processor and the OS counted for one thread
+struct CounterValues {
+    CounterValues() : cycles(0), instructions(0), cacheMisses(0),
+                      contextSwitches(0), cpuUsec(0), pageFaults(0) {}
+    double cycles;                      // from the PMU, 0 without one
+    double instructions;
+    double cacheMisses;                 // last level cache
+    double contextSwitches;             // voluntary and involuntary, from getrusage()
+    double cpuUsec;                     // user and system time
+    double pageFaults;                  // minor and major
+};
+
+// Counters of the thread creating it, see RInside::setEvalCounters().
+// Hardware counts come from perf_event_open() on Linux, as one group
+// scaled up for any time the kernel multiplexed it out; where that is not
+// allowed or there is no PMU to ask, as in many VMs, they stay 0 and only
+// the OS counts from getrusage() are there.
+class EvalCounters {
+public:
+    EvalCounters();
+    ~EvalCounters();
+
+    bool hardware() const {
+        for (int i = 0; i < Hardware; i++) {
+            if (fds_m[i] < 0) return false;
+        }
+        return true;
+    }
+    void read(CounterValues& values) const;
+
+private:
+    static const int Hardware = 3;      // cycles, instructions, cache misses
+    int fds_m[Hardware];
+
+    EvalCounters(const EvalCounters&);
+    EvalCounters& operator=(const EvalCounters&);
+};
+
+#endif
@@ -0,0 +1,129 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// InputSource.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_INPUTSOURCE_H
+#define RINSIDE_INPUTSOURCE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#ifndef WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <vector>
+#include <Mutex.h>
+
+// Console input pulled by R as it needs it, see Callbacks::setInputSource().
+// read() fills up to len bytes and returns how many, 0 at the end.  There is
+// no need to return whole lines: what R does not take yet is kept.  ready()
+// tells whether read() would return without blocking, which is what
+// RInside::replStep() asks before letting R read.
+class InputSource {
+public:
+    virtual ~InputSource() {}
+    virtual size_t read(char* buf, size_t len) = 0;
+    virtual bool ready() { return true; }
+};
+
+class MemoryInputSource : public InputSource {  // data is not copied and has to stay around
+public:
+    MemoryInputSource(const char* data, size_t len) : data_m(data), len_m(len), pos_m(0) {}
+    virtual size_t read(char* buf, size_t len) {
+        size_t n = (len < len_m - pos_m) ? len : len_m - pos_m;
+        memcpy(buf, data_m + pos_m, n);
+        pos_m += n;
+        return n;
+    }
+private:
+    const char* data_m;
+    size_t len_m, pos_m;
+};
+
+// eg a script, a pipe or stdin.  The descriptor is read directly, so that a
+// pipe or a terminal hands over what it has without waiting for a whole
+// buffer; nothing should have been read through fp before.
+class FileInputSource : public InputSource {
+public:
+    explicit FileInputSource(FILE* fp) : fp_m(fp) {}
+#ifndef WIN32
+    virtual size_t read(char* buf, size_t len) {
+        for (;;) {
+            ssize_t n = ::read(fileno(fp_m), buf, len);
+            if (n >= 0) return n;
+            if (errno != EINTR) return 0;       // an error ends the input like its end
+        }
+    }
+    virtual bool ready() {
+        struct pollfd pfd;
+        pfd.fd = fileno(fp_m);
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, 0) != 0;           // also for the end, or an error, to be seen
+    }
+#else
+    virtual size_t read(char* buf, size_t len) { return fread(buf, sizeof(char), len, fp_m); }
+#endif
+private:
+    FILE* fp_m;
+};
+
+// Input handed over by the host as it arrives, eg from an event loop; any
+// thread may feed().  read() blocks until there is data or close() was called.
+class FeedInputSource : public InputSource {
+public:
+    FeedInputSource() : pos_m(0), closed_m(false) {}
+    void feed(const char* data, size_t len) {
+        RInsideMutexLock lock(mutex_m);
+        if (pos_m == buf_m.size()) {
+            buf_m.clear();
+            pos_m = 0;
+        }
+        buf_m.insert(buf_m.end(), data, data + len);
+        cond_m.signal();
+    }
+    void close() {
+        RInsideMutexLock lock(mutex_m);
+        closed_m = true;
+        cond_m.signal();
+    }
+    virtual size_t read(char* buf, size_t len) {
+        RInsideMutexLock lock(mutex_m);
+        while (pos_m == buf_m.size() && !closed_m) cond_m.wait(mutex_m);
+        size_t n = (len < buf_m.size() - pos_m) ? len : buf_m.size() - pos_m;
+        if (n) memcpy(buf, &buf_m[pos_m], n);
+        pos_m += n;
+        return n;
+    }
+    virtual bool ready() {
+        RInsideMutexLock lock(mutex_m);
+        return pos_m < buf_m.size() || closed_m;
+    }
+private:
+    RInsideMutex mutex_m;
+    RInsideCondition cond_m;
+    std::vector<char> buf_m;
+    size_t pos_m;
+    bool closed_m;
+};
+
+#endif
@@ -0,0 +1,127 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Metrics.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_METRICS_H
+#define RINSIDE_METRICS_H
+
+#include <Mutex.h>
+#include <string>
+#include <vector>
+
+class RInsideHistogram;
+
+// Counters, gauges and histograms rendered in the Prometheus text format.
+// Updates take no lock: counts are spread over per-thread shards, each on
+// a cache line of its own, and only summed up when rendered.  Registering
+// a metric and rendering take the registry's mutex.  Metrics live as long
+// as the registry; registering a name and label set again returns the
+// existing one.
+class Metrics {
+public:
+    static const int Shards = 16;
+
+    class Counter {
+    public:
+        void inc(unsigned long n = 1);
+        unsigned long value() const;
+    private:
+        friend class Metrics;
+        Counter();
+        struct Slot {
+            volatile unsigned long n;
+            char pad[64 - sizeof(unsigned long)];
+        } slots_m[Shards];
+    };
+
+    class Gauge {
+    public:
+        void set(double v);
+        void add(double v);
+        double value() const;
+    private:
+        friend class Metrics;
+        Gauge();
+        volatile unsigned long long bits_m;     // of a double, so it can be swapped atomically
+    };
+
+    class Histogram {
+    public:
+        ~Histogram();
+        void observe(double v);
+    private:
+        friend class Metrics;
+        explicit Histogram(const std::vector<double>& bounds);
+        std::vector<double> bounds_m;   // upper bounds, ascending; +Inf is implied
+        struct Slot {
+            std::vector<unsigned long> counts;
+            volatile unsigned long long sum;    // bits of a double
+            char pad[64];
+        };
+        Slot* slots_m[Shards];
+    };
+
+    // appends samples of its own to the exposition, eg from existing statistics
+    typedef void (*Collector)(std::string& out, void* arg);
+
+    Metrics();
+    ~Metrics();
+
+    // labels are given preformatted, eg  stream="stdout"
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds, const std::string& labels = "");
+    void addCollector(Collector collector, void* arg);
+
+    std::string renderPrometheus();
+
+    static std::vector<double> exponentialBounds(double start, double factor, int count);
+
+    // helpers for collectors
+    static void appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type);
+    static void appendSample(std::string& out, const std::string& name, const std::string& labels, double value);
+    static void appendHistogram(std::string& out, const std::string& name, const std::string& labels,
+                                const RInsideHistogram& hist, double scale); // from Stats.h
+
+private:
+    struct Series {
+        std::string labels;
+        Counter* counter;
+        Gauge* gauge;
+        Histogram* histogram;
+    };
+    struct Family {
+        std::string name, help;
+        const char* type;
+        std::vector<Series> series;
+    };
+    RInsideMutex mutex_m;
+    std::vector<Family*> families_m;
+    std::vector<std::pair<Collector, void*> > collectors_m;
+
+    Series& series(const std::string& name, const std::string& help, const char* type, const std::string& labels);
+
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+};
+
+#endif
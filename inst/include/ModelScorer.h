@@ -0,0 +1,129 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// ModelScorer.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RINSIDE_MODELSCORER_H
+#define RINSIDE_MODELSCORER_H
+
+#include <RInsideCommon.h>
+#include <Mutex.h>
+
+#include <map>
+#include <deque>
+
+class RInside;
+
+// Scores fitted R models via predict(model, newdata) without parsing any
+// code per request.  Models are loaded once and kept by handle, bound in an
+// environment of their own where a predict() call parsed once refers to
+// them by symbol; for the batch sizes seen last a newdata data.frame of the
+// model's schema is built once and then refilled in place.
+//
+// score() runs a batch synchronously on the R thread.  Alternatively,
+// requests of single rows may be submit()ted from any thread while the R
+// thread sits in serve(), which groups them per model into micro-batches
+// bounded by size and by the latency budget of the oldest request.
+class ModelScorer {
+public:
+    struct Column {                     // one column of the newdata schema
+        Column(const std::string& n, int t = REALSXP) : name(n), type(t) {}
+        std::string name;
+        int type;                       // REALSXP, INTSXP, LGLSXP or STRSXP
+    };
+    typedef std::vector<Column> Schema;
+
+    class Request {                     // a single row to be scored
+    public:
+        Request(int model) : model_m(model), done_m(false), scorer_m(NULL), arrival_m(0) {}
+        // one entry per numeric (REALSXP, INTSXP, LGLSXP) and per STRSXP column
+        // respectively, each in schema order
+        std::vector<double> values;
+        std::vector<std::string> strings;
+
+        void wait();
+        const std::vector<double>& result() const { return result_m; }
+        const std::string& error() const { return error_m; }
+
+    private:
+        friend class ModelScorer;
+        int model_m;
+        bool done_m;
+        ModelScorer* scorer_m;
+        std::vector<double> result_m;
+        std::string error_m;
+        double arrival_m;               // monotonicUsec()
+    };
+
+    explicit ModelScorer(RInside& R, size_t maxBatch = 64, long latencyUsec = 2000);
+    ~ModelScorer();
+
+    // R thread: 'expr' is evaluated once to obtain the model, eg readRDS(...);
+    // 'args' are extra arguments to predict(), eg "type = \"response\""
+    int loadModel(const std::string& expr, const Schema& schema, const std::string& args = "");
+    int addModel(SEXP model, const Schema& schema, const std::string& args = "");
+    void unloadModel(int model);
+
+    // R thread: 'columns' holds one pointer per schema column to 'nrows'
+    // doubles, ints or const char* respectively; predictions are returned
+    // column-major in 'out', and the number of prediction columns returned
+    size_t score(int model, const std::vector<const void*>& columns, size_t nrows, std::vector<double>& out);
+
+    void submit(Request* request);      // any thread, request is not owned
+    void serve();                       // R thread: run micro-batches until shutdown()
+    void flush();                       // R thread: score everything queued right now
+    void shutdown();                    // any thread
+
+private:
+    struct Frame {
+        SEXP data;                      // preallocated newdata
+        unsigned long used;             // Model::uses when last used
+    };
+    struct Model {
+        Model() : uses(0) {}
+        SEXP env;                       // binds .model, and .newdata per batch
+        Schema schema;
+        SEXP call;                      // predict(.model, .newdata, ...) as parsed
+        std::map<size_t, Frame> frames; // per batch size, the ones used last
+        unsigned long uses;
+    };
+
+    RInside& R_m;
+    size_t maxBatch_m;
+    long latency_m;
+    std::map<int, Model*> models_m;
+    int next_m;
+
+    RInsideMutex mutex_m;
+    RInsideCondition queued_m;
+    RInsideCondition done_m;
+    std::deque<Request*> pending_m;
+    bool shutdown_m;
+
+    Model* find(int model);
+    SEXP frame(Model* m, size_t nrows);
+    void fill(Model* m, SEXP df, const std::vector<const void*>& columns, size_t nrows);
+    void scoreBatch(std::vector<Request*>& batch);
+    void complete(std::vector<Request*>& batch);
+
+    ModelScorer(const ModelScorer&);
+    ModelScorer& operator=(const ModelScorer&);
+};
+
+#endif
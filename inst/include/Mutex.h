@@ -0,0 +1,85 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Mutex.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RINSIDE_MUTEX_H
+#define RINSIDE_MUTEX_H
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <errno.h>
+
+// minimal wrappers around pthreads for the few places where RInside
+// itself has to cope with host threads; R remains single-threaded
+class RInsideMutex {
+private:
+    pthread_mutex_t mutex_m;
+
+    RInsideMutex(const RInsideMutex&);  // not copyable
+    RInsideMutex& operator=(const RInsideMutex&);
+
+    friend class RInsideCondition;
+
+public:
+    RInsideMutex()         { pthread_mutex_init(&mutex_m, NULL); }
+    ~RInsideMutex()        { pthread_mutex_destroy(&mutex_m); }
+
+    void lock()     { pthread_mutex_lock(&mutex_m); }
+    void unlock()   { pthread_mutex_unlock(&mutex_m); }
+};
+
+class RInsideMutexLock {                // scoped lock
+private:
+    RInsideMutex& mutex_m;
+
+    RInsideMutexLock(const RInsideMutexLock&);
+    RInsideMutexLock& operator=(const RInsideMutexLock&);
+
+public:
+    explicit RInsideMutexLock(RInsideMutex& mutex) : mutex_m(mutex) { mutex_m.lock(); }
+    ~RInsideMutexLock()    { mutex_m.unlock(); }
+};
+
+class RInsideCondition {                // condition variable, used with a locked RInsideMutex
+private:
+    pthread_cond_t cond_m;
+
+    RInsideCondition(const RInsideCondition&);
+    RInsideCondition& operator=(const RInsideCondition&);
+
+public:
+    RInsideCondition()     { pthread_cond_init(&cond_m, NULL); }
+    ~RInsideCondition()    { pthread_cond_destroy(&cond_m); }
+
+    void wait(RInsideMutex& mutex) { pthread_cond_wait(&cond_m, &mutex.mutex_m); }
+    bool wait(RInsideMutex& mutex, long usec) {  // false on timeout
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        long long ns = (now.tv_usec + (long long) usec) * 1000;
+        struct timespec until;
+        until.tv_sec = now.tv_sec + ns / 1000000000;
+        until.tv_nsec = ns % 1000000000;
+        return pthread_cond_timedwait(&cond_m, &mutex.mutex_m, &until) != ETIMEDOUT;
+    }
+    void signal()   { pthread_cond_signal(&cond_m); }
+    void broadcast() { pthread_cond_broadcast(&cond_m); }
+};
+
+#endif
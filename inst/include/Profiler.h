@@ -0,0 +1,91 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Profiler.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_PROFILER_H
+#define RINSIDE_PROFILER_H
+
+#include <pthread.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// time and memory attributed to one R function by R's sampling profiler
+struct RInsideProfileEntry {
+    RInsideProfileEntry() : selfSamples(0), totalSamples(0), selfBytes(0), totalBytes(0) {}
+    std::string name;
+    long selfSamples;                   // samples with the function on top of the stack
+    long totalSamples;                  // samples with the function anywhere on it
+    double selfBytes, totalBytes;       // allocated between samples, with memory profiling
+};
+
+// aggregated samples, see RInside::startProfiler()
+struct RInsideProfile {
+    RInsideProfile() : interval(0), samples(0), bytes(0) {}
+    double interval;                    // seconds between samples
+    long samples;
+    double bytes;                       // allocated in all, with memory profiling
+    std::vector<RInsideProfileEntry> functions; // by total samples, most first
+
+    double seconds(long n) const { return n * interval; }
+};
+
+// Reads what Rprof() writes through a FIFO, on a thread of its own, and
+// aggregates it as it arrives; nothing goes to disk and memory use does
+// not grow with the length of the run.  With tracing enabled the stacks
+// seen are also recorded as nested spans.  Used by RInside.
+class RInsideProfiler {
+public:
+    explicit RInsideProfiler(const std::string& dir);
+    ~RInsideProfiler();
+
+    const std::string& path() const { return path_m; }
+    void start();                       // before Rprof() opens path()
+    void abandon();                     // Rprof() failed, release the reader
+    RInsideProfile finish();            // after Rprof(NULL)
+
+private:
+    std::string path_m;
+    pthread_t reader_m;
+    bool running_m;
+
+    struct Counts {
+        Counts() : self(0), total(0), selfBytes(0), totalBytes(0) {}
+        long self, total;
+        double selfBytes, totalBytes;
+    };
+    std::map<std::string, Counts> counts_m;
+    RInsideProfile profile_m;
+    double lastBytes_m;                 // memory counters of the previous sample
+    double start_m;                     // monotonic time of the first sample
+    std::vector<std::string> open_m;    // trace spans open, outermost first
+    std::vector<double> opened_m;
+
+    static void* readerMain(void* self);
+    void read();
+    void sample(const std::string& line);
+    void traceStack(const std::vector<std::string>& stack, double now);
+
+    RInsideProfiler(const RInsideProfiler&);
+    RInsideProfiler& operator=(const RInsideProfiler&);
+};
+
+#endif
@@ -25,8 +25,43 @@
 
 #include <RInsideCommon.h>
 #include <Callbacks.h>
+#include <Mutex.h>
+#include <Snapshot.h>
+#include <WorkQueue.h>
+#include <Timing.h>
+#include <Trace.h>
+#include <Stats.h>
+#include <Counters.h>
+#include <Metrics.h>
+#include <BufferedConsole.h>
+#include <ConditionSink.h>
+#include <SvgDevice.h>
+#include <Profiler.h>
 
 class RInside {
+public:
+    class Options {                         // settings for RInside(argc, argv, options)
+    public:
+        Options() : loadRcpp(true), verbose(false), interactive(false), deferAutoloads(false),
+                    defaultPackages(), vsize(0), nsize(0), maxVSize(0), maxNSize(0),
+                    tempBase(), tempLimit(0) {}
+        bool loadRcpp;                      // if false, Rcpp is loaded when first needed by RInside
+                                            // itself: load it before using Rcpp objects directly
+        bool verbose;
+        bool interactive;
+        bool deferAutoloads;                // set up autoloads only once a lookup misses everywhere else
+        std::string defaultPackages;        // packages to attach and autoload, comma-separated as for
+                                            // R_DEFAULT_PACKAGES; "NULL" for none, empty for R's default
+        size_t vsize;                       // vector heap size in bytes before a collection is triggered
+        size_t nsize;                       // likewise in cons cells; both only ever raise R's defaults
+        size_t maxVSize;                    // hard limits as for mem.maxVSize(), 0 for none
+        size_t maxNSize;
+        std::string tempBase;               // where the private temporary directory is made, eg a
+                                            // tmpfs such as /dev/shm; empty for TMPDIR, TMP, TEMP or /tmp
+        size_t tempLimit;                   // bytes the directory may hold after an evaluation, 0 for
+                                            // any; measured at most once a second, see tempExceeded()
+    };
+
 private:
     MemBuf mb_m;
     Rcpp::Environment* global_env_m;
@@ -34,12 +69,130 @@ private:
     bool verbose_m;							// switch toggled by constructor, or setter
 	bool interactive_m;						// switch set by constructor only
 
-    void init_tempdir(void);
+    pthread_t r_thread_m;                   // the thread R was initialized on
+    RInsideMutex released_mutex_m;          // guards released_m
+    std::vector<SEXP> released_m;           // snapshots dropped off the R thread
+
+    void releaseSnapshot(SEXP x);
+    friend class RInsideSnapshot;
+
+    WorkQueue* queue_m;                     // optional, consulted between top-level expressions
+
+    void init_tempdir(const std::string& base);
+    void removeTempDir(void);
+    size_t temp_limit_m;
+    bool temp_exceeded_m;                   // the directory held too much when last measured
+    double temp_checked_m;                  // monotonicUsec() then
+    void checkTempLimit(void);
     void init_rand(void);
     void autoloads(void);
+    void defer_autoloads(void);
+    std::vector<std::string> autoload_packages_m;   // empty for all
+    bool autoload_all_m;
+    bool autoloads_pending_m;               // deferred autoloads not yet set up
+    friend class AutoloadTable;
     
-    void initialize(const int argc, const char* const argv[], 
-					const bool loadRcpp, const bool verbose, const bool interactive);
+    void initialize(const int argc, const char* const argv[], const Options& options);
+
+    bool rcpp_loaded_m;
+    void ensureRcpp(void);                  // load Rcpp and set up global_env_m on first use
+
+    SEXP baseline_m;                        // environment holding the state reset() returns to
+    void init_baseline(void);
+
+    int parseEvalEnv(const std::string &line, SEXP &ans, SEXP env, size_t budget = 0, bool accounted = true);
+    int evalExpressions(SEXP cmdexpr, SEXP env, SEXP &ans);
+    std::string errorMessage(const std::string &line);
+
+    structRstart params_m;                  // as given to R_SetParams(), with the current gc triggers
+    void setGcTriggers(size_t vcells, size_t ncells);
+
+    RInsideMutex stats_mutex_m;             // guards eval_stats_m, gc_stats_m and gc_telemetry_m
+    EvalStats eval_stats_m;
+    EvalCounters* counters_m;               // NULL unless setEvalCounters(true)
+
+    Metrics metrics_m;
+    Metrics::Counter* m_evals_m;
+    Metrics::Counter* m_errors_m;
+    Metrics::Histogram* m_latency_m;
+    Metrics::Counter* m_console_m[2];       // by stream, stdout and stderr
+    Metrics::Counter* m_conversions_m[2];   // from R, to R
+    Metrics::Counter* m_conversion_bytes_m[2];
+    void init_metrics(void);
+    static void collectMetrics(std::string& out, void* arg);
+    void countConsole(int len, int otype);
+    struct EvalStart {
+        double usec;
+        bool accounted;                     // false for RInside's own evaluations
+        bool counted;
+        CounterValues counters;
+    };
+    void evalBegin(EvalStart& start, bool accounted = true);
+    int evalDone(const EvalStart& start, int rc);
+
+    struct MemoryMark {                     // heap state at the start of an evaluation
+        bool active;
+        size_t budget;
+        double ncells, vcells;
+        bool limited;                       // for a budget, with the limits to restore:
+        double maxVSize, maxNSize;          // in Mb and cells as mem.maxVSize() and
+                                            // mem.maxNSize() have them, Inf for none
+    };
+    bool memory_accounting_m;
+    size_t eval_budget_m;
+    int eval_depth_m;                       // only the outermost evaluation is accounted
+    EvalMemory last_memory_m;
+    SEXP mem_reset_call_m, mem_peak_call_m;
+    bool gcCells(SEXP call, double cells[4]);
+    void memoryBegin(MemoryMark& mark, size_t budget);
+    void memoryEnd(const MemoryMark& mark, bool failed);
+
+    struct GcEvent {                        // one gcinfo() report
+        int level;
+        double consBytes, consHeapBytes, vectorBytes, vectorHeapBytes;
+    };
+    GcStats gc_stats_m;
+    bool gc_telemetry_m;
+    int gc_info_prev_m;                     // gcinfo() setting before telemetry was turned on
+    SEXP gc_time_call_m;
+    double gc_elapsed_m;                    // gc.time() at the last probe, seconds
+    std::string gc_report_m;                // report being written
+    std::vector<GcEvent> gc_pending_m;      // reported, waiting for the probe to time them
+    bool gcReport(const char* buf, int len);
+    void gcProbe(void);
+    void gcArmProbe(void);
+    friend void RInside_GcProbe(SEXP probe);
+
+    bool console_routed_m;                  // R's console output passes through consoleWrite()
+    FILE* console_out_m;                    // where it went before
+    FILE* console_err_m;
+    void (*console_prev_m)(const char*, int, int);
+    void (*console_prev_plain_m)(const char*, int);  // used by R when there is no Ex one
+    void routeConsole(void);
+    RInsideProfiler* profiler_m;            // while R's profiler writes to us
+
+    ConditionSink* condition_sink_m;
+    SEXP condition_wrapper_m;               // function(expr) withCallingHandlers(expr, ...)
+    friend SEXP RInside_Condition(SEXP type, SEXP classes, SEXP message, SEXP call);
+
+    ConsoleSink* capture_m;                 // takes the output of parseEvalCapture()
+    bool capture_messages_m;                // also oType 1
+    void consoleWrite(const char* buf, int len, int otype);
+    friend void RInside_ConsoleRouter(const char* buf, int len, int otype);
+
+public:
+    struct StartupPhase {                   // one step of initialize(), see startupReport()
+        std::string name;
+        double usec;                        // elapsed, monotonic clock
+        long rssKb;                         // resident set size at its end
+        long rssDeltaKb;                    // growth during it
+    };
+
+private:
+    std::vector<StartupPhase> startup_m;
+    double phase_start_m;
+    long phase_rss_m;
+    void startupPhase(const char* name);
 
     static RInside* instance_m ;
 
@@ -52,6 +205,10 @@ private:
     friend void RInside_FlushConsole();
     friend void RInside_ClearerrConsole();
     friend void RInside_Busy(int which);
+    friend void RInside_ProcessEvents();
+    std::string repl_input_m;               // read for replStep(), not yet parsed
+    std::string repl_expr_m;                // lines of an expression still incomplete
+    int replEval(const std::string& text, bool last = false);
 #endif 
 
 public:
@@ -62,39 +219,223 @@ public:
 	
 	    template <typename T>
 	    operator T() {
+			RInsideTraceSpan span("convert", "Proxy");
+			countConversion(x, false);
 			return ::Rcpp::as<T>(x);
 	    }
 	private:
 	    Rcpp::RObject x;
 	};
 
+    // An isolated set of variables for one user or client: evaluation happens
+    // in a private environment whose parent is the global environment, so
+    // attached packages and shared globals are visible while assignments
+    // stay in the session.  Obtained (and created) via RInside::session().
+    class Session {
+    public:
+        const std::string& name() const	{ return name_m; }
+        SEXP environment() const			{ return env_m; }
+        size_t bytes();						// estimated heap usage of its variables
+        void setBudget(size_t bytes)		{ budget_m = bytes; }	// per evaluation, instead of RInside's
+
+        int  parseEval(const std::string &line, SEXP &ans);
+        void parseEvalQ(const std::string &line);
+        void parseEvalQNT(const std::string &line);
+        Proxy parseEval(const std::string &line);
+        Proxy parseEvalNT(const std::string &line);
+
+        template <typename T>
+        void assign(const T& object, const std::string& nam) {
+            SEXP x = PROTECT(::Rcpp::wrap(object));
+            countConversion(x, true);
+            rcppEnv().assign( nam, x ) ;
+            assigned(nam, x);
+            UNPROTECT(1);
+        }
+
+        // like Rcpp's, but assignments go through assign() and so count
+        // towards the session limit
+        class Binding {
+        public:
+            template <typename T>
+            Binding& operator=(const T& rhs) { session_m.assign(rhs, name_m); return *this; }
+            template <typename T>
+            operator T() const { return ::Rcpp::as<T>(session_m.rcppEnv().get(name_m)); }
+        private:
+            friend class Session;
+            Binding(Session& session, const std::string& name) : session_m(session), name_m(name) {}
+            Session& session_m;
+            std::string name_m;
+        };
+        Binding operator[]( const std::string& name );
+
+    private:
+        Session(RInside& R, const std::string& name);
+        ~Session();
+        Rcpp::Environment& rcppEnv();
+        void used();						// mark as most recently used
+        void assigned(const std::string& name, SEXP x);	// account for it, then evict as needed
+        void measure();
+
+        struct Sized {						// a binding as last measured
+            Sized() : object(NULL), length(0), elements(0), bytes(0) {}
+            SEXP object;
+            R_xlen_t length;
+            size_t elements;				// for lists, their element pointers summed up
+            size_t bytes;
+        };
+        RInside& R_m;
+        std::string name_m;
+        SEXP env_m;
+        Rcpp::Environment* rcpp_env_m;
+        unsigned long last_use_m;
+        std::map<std::string, Sized> sizes_m;
+        size_t bytes_m;						// sum over sizes_m
+        bool dirty_m;						// bindings may have changed since measured
+        int busy_m;							// evaluations in progress, never evicted then
+        size_t budget_m;
+        friend class RInside;
+        friend class Binding;
+    };
+
+private:
+    friend class Session;
+    std::map<std::string, Session*> sessions_m;
+    unsigned long session_clock_m;          // ticks on every use, orders sessions for eviction
+    size_t session_limit_m;                 // bytes, 0 for no limit
+    void evictSessions(const Session* keep);
+
+public:
     int  parseEval(const std::string &line, SEXP &ans); // parse line, return in ans; error code rc
     void parseEvalQ(const std::string &line);			// parse line, no return (throws on error)
     void parseEvalQNT(const std::string &line);			// parse line, no return (no throw)
     Proxy parseEval(const std::string &line);		 	// parse line, return SEXP (throws on error)
     Proxy parseEvalNT(const std::string &line);			// parse line, return SEXP (no throw)
 
+    // Output printed while evaluating line, taken from R's console hook as it
+    // is written instead of via capture.output() and a textConnection.  Only
+    // regular output unless messages is set, which adds messages, warnings
+    // and errors (oType 1).  Captures nest.  Not available on Windows.
+    int  parseEvalCapture(const std::string &line, SEXP &ans, std::string &output, bool messages = false);
+    int  parseEvalCapture(const std::string &line, SEXP &ans, ConsoleSink &sink, bool messages = false);
+    std::string parseEvalCapture(const std::string &line, bool messages = false);	// throws on error
+
+    // Run an R script from disk one top-level statement at a time, without
+    // holding its text in memory.  Stopping at the first error throws with
+    // file:line; otherwise failing statements are skipped and counted.
+    int  parseEvalFile(const std::string &path, bool stopOnError = true);
+
     template <typename T> 
     void assign(const T& object, const std::string& nam) {
-		global_env_m->assign( nam, object ) ;
+		ensureRcpp();
+		RInsideTraceSpan span("convert", "assign");
+		SEXP x = PROTECT(::Rcpp::wrap(object));
+		countConversion(x, true);
+		global_env_m->assign( nam, x ) ;
+		UNPROTECT(1);
     }
     
     RInside() ;
     RInside(const int argc, const char* const argv[], 
-			const bool loadRcpp=true, 					// overridden in code, cannot be set to false 
+			const bool loadRcpp=true, 					// overridden in code, cannot be set to false
 			const bool verbose=false, const bool interactive=false);
+    RInside(const int argc, const char* const argv[], const Options& options);
     ~RInside();
 
 	void setVerbose(const bool verbose) 	{ verbose_m = verbose; }
 
+    const std::vector<StartupPhase>& startupReport() const { return startup_m; }
+    void printStartupReport(std::ostream& os) const;	// also done on stderr if RINSIDE_STARTUP_REPORT is set
+
     Rcpp::Environment::Binding operator[]( const std::string& name );
+
+    RInsideSnapshot snapshot(const std::string& name);	// pin a vector from the global env for reading from any thread
+    RInsideSnapshot snapshot(SEXP x);
+    void releaseSnapshots();					// unprotect snapshots dropped on other threads
+
+    void setWorkQueue(WorkQueue* queue)	{ queue_m = queue; }	// lets queued urgent work preempt between expressions
+    WorkQueue* getWorkQueue()			{ return queue_m; }
     
+    void reset();								// return to the state right after construction
+
+    void gc(bool full = true);					// collect garbage now, or only the younger generations
+
+    EvalStats evalStats();						// per-call latency of the parseEval() family
+    GcStats gcStats();							// collections seen since setGcTelemetry(true)
+    void resetStats();
+    void setGcTelemetry(bool on);				// follow R's gcinfo() reports, time collections via gc.time()
+    void setEvalCounters(bool on);				// add CPU and OS counters to evalStats(), R thread only
+
+    Metrics& metrics();							// RInside's own, and room for the host's
+    std::string renderPrometheus();				// any thread, eg a scrape handler
+    static void countConversion(SEXP x, bool toR);	// for metrics, cheap estimate of the size
+
+    // R's sampling profiler, aggregated in memory by function; around one
+    // evaluation, or anything between start and stop, including sessions
+    void startProfiler(double interval = 0.02, bool memory = false);
+    RInsideProfile stopProfiler();
+    RInsideProfile profile(const std::string &line, double interval = 0.02, bool memory = false);	// throws on error
+
+    std::string tempDir() const;				// R's tempdir(), private to this instance
+    size_t tempBytes() const;					// size of the files in it
+    bool tempExceeded() const { return temp_exceeded_m; }	// over Options::tempLimit after an evaluation
+
+    // With a sink, every top-level expression runs inside calling handlers
+    // which hand messages, warnings and errors to it; messages and warnings
+    // are then muffled, errors go on as before.  Without one (the default,
+    // NULL) evaluation is not wrapped at all.
+    void setConditionSink(ConditionSink* sink);
+
+    // Accounting measures the peak heap growth of each top-level evaluation,
+    // at the cost of a collection before and after it.  A budget, in bytes,
+    // turns accounting on and makes allocations beyond it fail with an R
+    // error; R never lowers its limits below the current heap size, so
+    // small budgets are only enforced that coarsely.
+    void setMemoryAccounting(bool on)			{ memory_accounting_m = on; }
+    void setEvalBudget(size_t bytes)			{ eval_budget_m = bytes; }		// 0 for none
+    const EvalMemory& lastEvalMemory() const	{ return last_memory_m; }
+
+    // Raises the thresholds at which R collects garbage for as long as it
+    // lives, so that a latency-critical section runs without collections
+    // unless it allocates more than vsize bytes of vectors or nsize cons
+    // cells.  Scopes nest; on exit the previous thresholds are restored.
+    class GcScope {
+    public:
+        GcScope(RInside& R, size_t vsize, size_t nsize = 0);
+        ~GcScope();
+    private:
+        RInside& R_m;
+        size_t vcells_m, ncells_m;			// thresholds to restore
+        GcScope(const GcScope&);
+        GcScope& operator=(const GcScope&);
+    };
+
+    // Sessions live until dropped, evicted or reset().  When the estimated
+    // total of all sessions exceeds the limit, the least recently used idle
+    // ones are evicted, so look sessions up by name for each request rather
+    // than holding on to the reference.
+    Session& session(const std::string& name);	// find or create, counts as a use
+    bool hasSession(const std::string& name) const;
+    void dropSession(const std::string& name);
+    void dropSessions();
+    size_t sessionBytes();						// estimated total over all sessions
+    void setSessionLimit(size_t bytes);			// 0 (the default) for no limit
+
     static RInside& instance();
     static RInside* instancePtr();
     
 #ifdef RINSIDE_CALLBACKS
     void set_callbacks(Callbacks* callbacks_) ;
 	void repl() ;
+
+	// repl() in steps, for hosts with their own event loop: run at most
+	// maxExpressions top-level expressions or until maxUsec have passed
+	// (checked between expressions), 0 for no limit.  Returns ReplNeedInput
+	// rather than blocking when the input source has nothing ready.  Errors
+	// are shown as by repl() and the next line goes on, and whatever the
+	// caller has protected stays so.
+	enum ReplStatus { ReplYield, ReplNeedInput, ReplEnd };
+	ReplStatus replStep(int maxExpressions = 0, long maxUsec = 0) ;
 #endif
 
 };
@@ -33,6 +33,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <iostream>
 
 #include <Rcpp.h>
@@ -54,8 +55,10 @@
 #ifndef WIN32
   #define R_INTERFACE_PTRS
   #include <Rinterface.h>
+  #include <R_ext/eventloop.h>
 #endif
 #include <R_ext/RStartup.h>
+#include <R_ext/RObjectTables.h>
 
 #include <MemBuf.h>
 
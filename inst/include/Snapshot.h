@@ -0,0 +1,65 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Snapshot.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RINSIDE_SNAPSHOT_H
+#define RINSIDE_SNAPSHOT_H
+
+#include <RInsideCommon.h>
+
+// A pinned, immutable view of an atomic R vector.  It is created on the
+// thread running R (see RInside::snapshot()), after which copies of the
+// handle may be passed to, and read concurrently from, any thread without
+// locking or copying the data.  The R object stays protected until the
+// last copy goes away; that release is handed back to the R thread.
+class RInsideSnapshot {
+public:
+    RInsideSnapshot();
+    explicit RInsideSnapshot(SEXP x);   // must be called on the R thread
+    RInsideSnapshot(const RInsideSnapshot& other);
+    RInsideSnapshot& operator=(const RInsideSnapshot& other);
+    ~RInsideSnapshot();
+
+    bool empty() const                  { return state_m == NULL; }
+    int type() const                    { return state_m ? state_m->type : NILSXP; }
+    size_t size() const                 { return state_m ? state_m->size : 0; }
+    const void* data() const            { return state_m ? state_m->data : NULL; }
+
+    const double* real() const;         // typed access, throws on type mismatch
+    const int* integer() const;
+    const int* logical() const;
+    const Rbyte* raw() const;
+    const Rcomplex* complex() const;
+
+private:
+    struct State {
+        SEXP x;
+        const void* data;
+        size_t size;
+        int type;
+        volatile int refs;
+    };
+    State* state_m;
+
+    const void* typed(int type) const;
+    void release();
+};
+
+#endif
@@ -0,0 +1,106 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Stats.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_STATS_H
+#define RINSIDE_STATS_H
+
+// Fixed-size histogram with power-of-two buckets: bucket i counts values
+// in (2^(i-1), 2^i], bucket 0 everything up to 1 and the last bucket
+// everything above 2^(Buckets-2).  Bounds are inclusive as Prometheus has
+// them for le, so buckets can be exposed as they are.  Cheap enough to update
+// on every call, and precise to within a factor of two for quantiles.
+class RInsideHistogram {
+public:
+    static const int Buckets = 48;
+
+    RInsideHistogram() { reset(); }
+
+    void add(double value);
+    void reset();
+
+    unsigned long count() const     { return count_m; }
+    double sum() const              { return sum_m; }
+    double min() const              { return count_m ? min_m : 0.0; }
+    double max() const              { return count_m ? max_m : 0.0; }
+    double mean() const             { return count_m ? sum_m / count_m : 0.0; }
+    double quantile(double q) const;    // interpolated within the bucket
+
+    unsigned long bucketCount(int i) const { return buckets_m[i]; }
+    static double bucketUpper(int i);   // inclusive upper bound of bucket i
+
+private:
+    unsigned long buckets_m[Buckets];
+    unsigned long count_m;
+    double sum_m, min_m, max_m;
+};
+
+// R heap growth during one evaluation, see RInside::setMemoryAccounting()
+struct EvalMemory {
+    EvalMemory() : ncells(0), vcells(0), bytes(0), budgetExceeded(false) {}
+    double ncells;                      // cons cells above the level at the start, at the peak
+    double vcells;                      // likewise for 8-byte vector cells
+    double bytes;                       // both together
+    bool budgetExceeded;                // the evaluation was aborted for exceeding its budget
+};
+
+// per-call statistics over RInside::parseEval() and friends
+struct EvalStats {
+    EvalStats() : calls(0), errors(0), overBudget(0), counted(0), hardwareCounted(0) {}
+    unsigned long calls;
+    unsigned long errors;               // parse or evaluation errors
+    unsigned long overBudget;           // errors due to a memory budget
+    RInsideHistogram latencyUsec;       // wall time per call, including parsing
+    RInsideHistogram allocBytes;        // only while memory accounting is on
+
+    // per call while RInside::setEvalCounters(true), see EvalCounters
+    unsigned long counted;
+    unsigned long hardwareCounted;      // of these, with cycles, instructions and cache misses
+    RInsideHistogram cycles;
+    RInsideHistogram instructions;
+    RInsideHistogram cacheMisses;
+    RInsideHistogram contextSwitches;
+    RInsideHistogram cpuUsec;           // compare with latencyUsec for time spent off the CPU
+    RInsideHistogram pageFaults;
+
+    double ipc() const { return cycles.sum() > 0 ? instructions.sum() / cycles.sum() : 0.0; }
+};
+
+// R's garbage collections as seen with RInside::setGcTelemetry(true)
+struct GcStats {
+    GcStats() : collections(0), reclaimedBytesMax(0), consBytes(0), vectorBytes(0),
+                consHeapBytes(0), vectorHeapBytes(0) {
+        for (int i = 0; i < Levels; i++) byLevel[i] = 0;
+    }
+    static const int Levels = 3;        // generations collected: 0 youngest only, 2 full
+    unsigned long collections;
+    unsigned long byLevel[Levels];
+    RInsideHistogram pauseUsec;         // all collections
+    RInsideHistogram pauseUsecByLevel[Levels];
+    double reclaimedBytesMax;           // at most reclaimed: the heap size before less the use
+                                        // after, as R does not report the use before
+    double consBytes;                   // in use after the last collection
+    double vectorBytes;
+    double consHeapBytes;               // heap sizes, ie next collection thresholds
+    double vectorHeapBytes;
+};
+
+#endif
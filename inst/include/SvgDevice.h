@@ -0,0 +1,72 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// SvgDevice.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_SVGDEVICE_H
+#define RINSIDE_SVGDEVICE_H
+
+#include <string>
+
+// receives each finished page of an SvgDevice, on the R thread; an
+// exception thrown while R draws becomes an R error (a warning on close)
+class GraphicsSink {
+public:
+    virtual ~GraphicsSink() {}
+    virtual void page(const char* svg, size_t len, int number) = 0;
+};
+
+// An R graphics device drawing SVG into memory.  A page is handed to the
+// sink, or kept for svg(), when R starts the next one, when the device is
+// closed, and on flush(), so a host can show a plot as soon as the code
+// drawing it returns.  No files are involved.  Create it once R is up; it
+// is closed by dev.off() or by its destructor, whichever comes first.
+class SvgDevice {
+public:
+    SvgDevice(double width = 7, double height = 7, double pointsize = 12, GraphicsSink* sink = NULL);
+    ~SvgDevice();
+
+    void activate();                    // make this R's current device, as dev.set() would
+    void flush();                       // deliver the current page if anything was drawn since
+    void close();
+
+    bool isOpen() const { return dev_m != NULL; }
+    const std::string& svg() const { return svg_m; }   // the page delivered last
+    int pages() const { return pages_m; }
+
+private:
+    void* dev_m;                        // R's pGEDevDesc, NULL once closed
+    GraphicsSink* sink_m;
+    double width_m, height_m;           // in points, R's device units here
+    std::string body_m;                 // elements of the current page
+    std::string svg_m;
+    int pages_m;
+    bool dirty_m;
+    int clips_m;                        // clip paths defined on this page
+    std::string clip_m;                 // attribute applying the current one
+
+    void deliver();
+    friend struct SvgCallbacks;
+
+    SvgDevice(const SvgDevice&);
+    SvgDevice& operator=(const SvgDevice&);
+};
+
+#endif
@@ -0,0 +1,73 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Timing.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RINSIDE_TIMING_H
+#define RINSIDE_TIMING_H
+
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+#ifndef WIN32
+  #include <sys/resource.h>
+  #include <unistd.h>
+#endif
+
+// microseconds from a monotonic clock where we have one, else wall clock
+inline double monotonicUsec() {
+#if defined(CLOCK_MONOTONIC) && !defined(WIN32)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+    }
+#endif
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// current resident set size in kB, from /proc where available; elsewhere
+// the peak size reported by getrusage() is the best we can do; -1 if unknown
+inline long residentKb() {
+    long rss = -1;
+#ifndef WIN32
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        long size, pages;
+        if (fscanf(fp, "%ld %ld", &size, &pages) == 2) {
+            rss = pages * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        fclose(fp);
+    }
+    if (rss < 0) {
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        #ifdef __APPLE__
+            rss = ru.ru_maxrss / 1024;  // bytes on OS X
+        #else
+            rss = ru.ru_maxrss;
+        #endif
+        }
+    }
+#endif
+    return rss;
+}
+
+#endif
@@ -0,0 +1,77 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Trace.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RINSIDE_TRACE_H
+#define RINSIDE_TRACE_H
+
+#include <Timing.h>
+#include <string>
+
+// Spans of time recorded per thread into a fixed-size ring, newest events
+// overwriting the oldest, and written out on demand in the Chrome trace
+// event format read by chrome://tracing and Perfetto.  Recording takes no
+// lock; while tracing is off a span costs a flag test.  RInside itself
+// records parsing, evaluation, queue wait, queued jobs and conversions of
+// Proxy and assign(); hosts add their own spans with RInsideTraceSpan or record().
+class RInsideTrace {
+public:
+    struct Event {
+        char name[48];                  // truncated if longer
+        const char* category;           // must be a literal or otherwise outlive the trace
+        double start, duration;         // in usec, see monotonicUsec()
+    };
+
+    static void enable(size_t eventsPerThread = 65536);    // the size is used for rings made from now on
+    static void disable();
+    static bool enabled() { return enabled_m; }
+    static void clear();                // drop what has been recorded
+
+    static void record(const char* category, const char* name, double start, double duration);
+    static void setThreadName(const std::string& name);    // shown for the calling thread
+
+    // may be called from any thread, also while recording; the events of
+    // threads which have exited are written out once, then dropped
+    static std::string chromeJson();
+
+private:
+    static volatile bool enabled_m;
+};
+
+// records the time between construction and destruction, if tracing is on
+class RInsideTraceSpan {
+public:
+    RInsideTraceSpan(const char* category, const char* name) :
+        category_m(category), name_m(name), start_m(RInsideTrace::enabled() ? monotonicUsec() : -1) {}
+    ~RInsideTraceSpan() {
+        if (start_m >= 0) RInsideTrace::record(category_m, name_m, start_m, monotonicUsec() - start_m);
+    }
+
+private:
+    const char* category_m;
+    const char* name_m;
+    double start_m;
+
+    RInsideTraceSpan(const RInsideTraceSpan&);
+    RInsideTraceSpan& operator=(const RInsideTraceSpan&);
+};
+
+#endif
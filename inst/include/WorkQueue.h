@@ -0,0 +1,109 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// WorkQueue.h: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RINSIDE_WORKQUEUE_H
+#define RINSIDE_WORKQUEUE_H
+
+#include <RInsideCommon.h>
+#include <Mutex.h>
+
+#include <deque>
+
+class RInside;
+
+// Queue of work for the embedded R, filled from any thread and drained on
+// the thread running R.  Jobs are taken by priority class, subject to a
+// per-class budget of jobs in a row: once a class has had that many while
+// less urgent work waits, the next job is the most urgent of that work, or
+// the job it suspended.  While a job is inside parseEval(), jobs of a
+// strictly higher class may run between its top-level expressions (see
+// RInside::setWorkQueue()).
+class WorkQueue {
+public:
+    enum Priority { Interactive = 0, Normal = 1, Batch = 2 };
+    static const int Priorities = 3;
+
+    class Job {                         // subclass and implement run()
+    public:
+        Job();
+        virtual ~Job();
+        virtual void run(RInside& R) = 0;
+
+        void wait();                    // block until the job has run
+        bool done();
+        const std::string& error() const { return error_m; } // empty unless run() threw
+
+    private:
+        friend class WorkQueue;
+        WorkQueue* queue_m;
+        Priority priority_m;
+        bool done_m;
+        std::string error_m;
+        double submitted_m;             // for the queue wait in traces
+    };
+
+    class EvalJob : public Job {        // evaluates a string of R code
+    public:
+        explicit EvalJob(const std::string& code) : code_m(code) {}
+        virtual void run(RInside& R);
+    private:
+        std::string code_m;
+    };
+
+    explicit WorkQueue(RInside& R);
+    ~WorkQueue();
+
+    void setBudget(Priority priority, int maxInARow);     // default, or < 0: unlimited; 0 holds the class back
+    void setIdleCollection(long usec, bool full = false); // run(): collect garbage once idle for usec after work, 0 (default) never
+    void submit(Job* job, Priority priority = Normal);   // any thread, job is not owned
+    size_t depth();                     // number of queued jobs
+
+    // these must be called on the R thread
+    bool runOne();                      // run the next eligible job, if any
+    void runPending();                  // run until no job is eligible
+    void run();                         // serve jobs until shutdown()
+    void shutdown();                    // any thread
+    void yieldPoint();                  // called by RInside::parseEval()
+
+private:
+    RInside& R_m;
+    RInsideMutex mutex_m;
+    RInsideCondition queued_m;          // signalled on submit() and shutdown()
+    RInsideCondition done_m;            // broadcast when a job completes
+    std::deque<Job*> queue_m[Priorities];
+    int budget_m[Priorities];
+    int streak_m[Priorities];           // jobs taken in a row, reset once a less urgent one runs
+    std::vector<Priority> running_m;    // nesting of jobs currently executing
+    bool shutdown_m;
+    long idle_usec_m;
+    bool idle_full_m;
+    bool ran_m;                         // a job ran since the last idle collection
+
+    bool waiting(int p, int below);     // with mutex held
+    int eligible(int below);
+    Job* take(int below);
+    void execute(Job* job);
+
+    WorkQueue(const WorkQueue&);
+    WorkQueue& operator=(const WorkQueue&);
+};
+
+#endif
@@ -0,0 +1,196 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// BufferedConsole.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <BufferedConsole.h>
+#include <Timing.h>
+#include <string.h>
+#include <algorithm>
+
+BufferedConsole::BufferedConsole(ConsoleSink& target, size_t capacity)
+    : target_m(target), flush_size_m(capacity / 2), newline_m(false), interval_m(50000),
+      last_m(0), threaded_m(false), stop_m(false) {
+    for (int i = 0; i < 2; i++) {
+        rings_m[i].data.resize(capacity > 0 ? capacity : 1);
+        rings_m[i].head = rings_m[i].used = 0;
+        rings_m[i].since = 0.0;
+        rings_m[i].due = false;
+    }
+}
+
+BufferedConsole::~BufferedConsole() {
+    stopWriter();
+    flush();
+}
+
+void BufferedConsole::append(Ring& ring, const char* data, size_t len) {
+    size_t cap = ring.data.size();
+    if (ring.used == 0) {
+        ring.head = 0;                  // keep the data in one piece where we can
+        ring.since = monotonicUsec();
+    }
+    size_t tail = (ring.head + ring.used) % cap;
+    size_t first = std::min(len, cap - tail);
+    memcpy(&ring.data[tail], data, first);
+    memcpy(&ring.data[0], data + first, len - first);
+    ring.used += len;
+}
+
+// deliver straight from the ring; the bytes stay accounted for until
+// written so a concurrent append() never touches them
+void BufferedConsole::drain(int oType) {
+    Ring& ring = rings_m[oType];
+    while (ring.used > 0) {
+        size_t cap = ring.data.size();
+        size_t len = std::min(ring.used, cap - ring.head);
+        const char* data = &ring.data[ring.head];
+        mutex_m.unlock();
+        target_m.write(data, len, oType);
+        mutex_m.lock();
+        ring.head = (ring.head + len) % cap;
+        ring.used -= len;
+    }
+    ring.due = false;
+    space_m.broadcast();
+}
+
+void BufferedConsole::write(const char* data, size_t len, int oType) {
+    if (len == 0) return;
+    oType = oType ? 1 : 0;
+    RInsideMutexLock lock(mutex_m);
+    Ring& ring = rings_m[oType];
+    if (oType != last_m) {              // keep the order across streams
+        Ring& other = rings_m[last_m];
+        if (threaded_m) {
+            other.due = true;
+            wake_m.signal();
+            while (other.used > 0) space_m.wait(mutex_m);
+        } else {
+            drain(last_m);
+        }
+        last_m = oType;
+    }
+    size_t cap = ring.data.size();
+    bool was_empty = ring.used == 0;
+    if (!threaded_m && len >= cap) {    // nothing to gain from copying
+        drain(oType);
+        mutex_m.unlock();
+        target_m.write(data, len, oType);
+        mutex_m.lock();
+        return;
+    }
+    while (len > 0) {
+        if (ring.used == cap) {
+            if (threaded_m) {
+                ring.due = true;
+                wake_m.signal();
+                space_m.wait(mutex_m);
+            } else {
+                drain(oType);
+            }
+            continue;
+        }
+        size_t n = std::min(len, cap - ring.used);
+        append(ring, data, n);
+        if (newline_m && memchr(data, '\n', n) != NULL) ring.due = true;
+        data += n;
+        len -= n;
+    }
+    if (ring.used >= flush_size_m ||
+        (interval_m > 0 && monotonicUsec() - ring.since >= interval_m)) {
+        ring.due = true;
+    }
+    if (ring.due) {
+        if (threaded_m) {
+            wake_m.signal();
+        } else {
+            drain(oType);
+        }
+    } else if (threaded_m && was_empty) {
+        wake_m.signal();                // for the writer to time the flush interval from
+    }
+}
+
+void BufferedConsole::flush() {
+    {
+        RInsideMutexLock lock(mutex_m);
+        if (threaded_m) {
+            rings_m[0].due = rings_m[1].due = true;
+            wake_m.signal();
+            while (rings_m[0].used > 0 || rings_m[1].used > 0) space_m.wait(mutex_m);
+        } else {
+            drain(last_m == 0 ? 1 : 0); // the other one is older
+            drain(last_m);
+        }
+    }
+    target_m.flush();
+}
+
+void BufferedConsole::startWriter() {
+    RInsideMutexLock lock(mutex_m);
+    if (threaded_m) return;
+    stop_m = false;
+    if (pthread_create(&writer_m, NULL, writerMain, this) != 0) {
+        throw std::runtime_error("Could not start the console writer thread");
+    }
+    threaded_m = true;
+}
+
+void BufferedConsole::stopWriter() {
+    {
+        RInsideMutexLock lock(mutex_m);
+        if (!threaded_m) return;
+        stop_m = true;
+        wake_m.signal();
+    }
+    pthread_join(writer_m, NULL);       // it drains everything before leaving
+    RInsideMutexLock lock(mutex_m);
+    threaded_m = false;
+}
+
+void* BufferedConsole::writerMain(void* self) {
+    static_cast<BufferedConsole*>(self)->writerLoop();
+    return NULL;
+}
+
+// the flush interval runs out here as well, not only on the next write()
+void BufferedConsole::writerLoop() {
+    RInsideMutexLock lock(mutex_m);
+    for (;;) {
+        double now = monotonicUsec(), oldest = now;
+        for (int i = 0; i < 2; i++) {
+            if (rings_m[i].used == 0) continue;
+            if (interval_m > 0 && now - rings_m[i].since >= interval_m) rings_m[i].due = true;
+            oldest = std::min(oldest, rings_m[i].since);
+        }
+        if (rings_m[0].due || rings_m[1].due || stop_m) {
+            int other = last_m == 0 ? 1 : 0;
+            if (rings_m[other].used > 0) drain(other);
+            if (rings_m[last_m].used > 0) drain(last_m);
+            if (stop_m && rings_m[0].used == 0 && rings_m[1].used == 0) break;
+        } else if (interval_m > 0 && (rings_m[0].used > 0 || rings_m[1].used > 0)) {
+            long left = static_cast<long>(oldest + interval_m - now);
+            wake_m.wait(mutex_m, left > 0 ? left : 1);
+        } else {
+            wake_m.wait(mutex_m);
+        }
+    }
+}
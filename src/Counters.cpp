@@ -0,0 +1,107 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Counters.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Counters.h>
+#include <cstring>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+// one group under the first counter, so that all are counted over the same
+// time even when the kernel has to multiplex them with other users
+static int openCounter(unsigned long long config, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;            // all that an unprivileged process may count
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);   // this thread, any CPU
+}
+#endif
+
+EvalCounters::EvalCounters() {
+    for (int i = 0; i < Hardware; i++) {
+        fds_m[i] = -1;
+    }
+#ifdef __linux__
+    const unsigned long long configs[Hardware] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (int i = 0; i < Hardware; i++) {
+        fds_m[i] = openCounter(configs[i], fds_m[0]);
+        if (fds_m[i] < 0) {             // all or nothing, partial counts would mislead
+            for (int j = 0; j < i; j++) {
+                close(fds_m[j]);
+                fds_m[j] = -1;
+            }
+            break;
+        }
+    }
+#endif
+}
+
+EvalCounters::~EvalCounters() {
+#ifndef WIN32
+    for (int i = 0; i < Hardware; i++) {
+        if (fds_m[i] >= 0) close(fds_m[i]);
+    }
+#endif
+}
+
+void EvalCounters::read(CounterValues& values) const {
+    values = CounterValues();
+#ifdef __linux__
+    if (hardware()) {                   // the whole group from its leader
+        unsigned long long group[3 + Hardware];     // nr, time enabled, time running, counts
+        if (::read(fds_m[0], group, sizeof(group)) == (ssize_t) sizeof(group) && group[0] == Hardware &&
+            group[2] > 0) {
+            double scale = (double) group[1] / (double) group[2];   // for the time multiplexed out
+            values.cycles = group[3] * scale;
+            values.instructions = group[4] * scale;
+            values.cacheMisses = group[5] * scale;
+        }
+    }
+#endif
+#ifndef WIN32
+    struct rusage ru;
+#ifdef RUSAGE_THREAD
+    int who = RUSAGE_THREAD;            // evaluations run on one thread, others may be busy
+#else
+    int who = RUSAGE_SELF;
+#endif
+    if (getrusage(who, &ru) == 0) {
+        values.contextSwitches = ru.ru_nvcsw + ru.ru_nivcsw;
+        values.cpuUsec = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+        values.pageFaults = ru.ru_minflt + ru.ru_majflt;
+    }
+#endif
+}
@@ -0,0 +1,286 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Metrics.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Metrics.h>
+#include <Stats.h>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+    pthread_key_t shard_key;
+    pthread_once_t shard_once = PTHREAD_ONCE_INIT;
+    volatile unsigned long next_shard = 0;
+
+    void makeKey() {
+        pthread_key_create(&shard_key, NULL);
+    }
+
+    // threads are dealt shards in turn, stored off by one so 0 means none yet
+    int shard() {
+        pthread_once(&shard_once, makeKey);
+        size_t s = (size_t) pthread_getspecific(shard_key);
+        if (s == 0) {
+            s = __sync_fetch_and_add(&next_shard, 1) % Metrics::Shards + 1;
+            pthread_setspecific(shard_key, (void*) s);
+        }
+        return (int) s - 1;
+    }
+
+    union DoubleBits {
+        double d;
+        unsigned long long u;
+    };
+
+    double fromBits(unsigned long long u) {
+        DoubleBits b;
+        b.u = u;
+        return b.d;
+    }
+
+    unsigned long long toBits(double d) {
+        DoubleBits b;
+        b.d = d;
+        return b.u;
+    }
+
+    void addDouble(volatile unsigned long long* bits, double v) {
+        unsigned long long old, now;
+        do {
+            old = *bits;
+            now = toBits(fromBits(old) + v);
+        } while (!__sync_bool_compare_and_swap(bits, old, now));
+    }
+
+    void appendNumber(std::string& out, double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.15g", v);
+        out += buf;
+    }
+
+    std::string withLabel(const std::string& labels, const std::string& extra) {
+        if (labels.empty()) return extra;
+        return labels + "," + extra;
+    }
+}
+
+Metrics::Counter::Counter() {
+    memset(slots_m, 0, sizeof(slots_m));
+}
+
+void Metrics::Counter::inc(unsigned long n) {
+    __sync_fetch_and_add(&slots_m[shard()].n, n);
+}
+
+unsigned long Metrics::Counter::value() const {
+    unsigned long sum = 0;
+    for (int i = 0; i < Shards; i++) sum += slots_m[i].n;
+    return sum;
+}
+
+Metrics::Gauge::Gauge() : bits_m(toBits(0.0)) {}
+
+void Metrics::Gauge::set(double v) {
+    unsigned long long old;
+    do {
+        old = bits_m;
+    } while (!__sync_bool_compare_and_swap(&bits_m, old, toBits(v)));
+}
+
+void Metrics::Gauge::add(double v) {
+    addDouble(&bits_m, v);
+}
+
+double Metrics::Gauge::value() const {
+    return fromBits(bits_m);
+}
+
+Metrics::Histogram::Histogram(const std::vector<double>& bounds) : bounds_m(bounds) {
+    for (int i = 0; i < Shards; i++) {
+        slots_m[i] = new Slot;
+        slots_m[i]->counts.assign(bounds_m.size() + 1, 0);
+        slots_m[i]->sum = toBits(0.0);
+    }
+}
+
+Metrics::Histogram::~Histogram() {
+    for (int i = 0; i < Shards; i++) delete slots_m[i];
+}
+
+void Metrics::Histogram::observe(double v) {
+    size_t b = 0;
+    while (b < bounds_m.size() && v > bounds_m[b]) b++;
+    Slot* slot = slots_m[shard()];
+    __sync_fetch_and_add(&slot->counts[b], 1);
+    addDouble(&slot->sum, v);
+}
+
+Metrics::Metrics() {}
+
+Metrics::~Metrics() {
+    for (size_t f = 0; f < families_m.size(); f++) {
+        for (size_t s = 0; s < families_m[f]->series.size(); s++) {
+            Series& ser = families_m[f]->series[s];
+            delete ser.counter;
+            delete ser.gauge;
+            delete ser.histogram;
+        }
+        delete families_m[f];
+    }
+}
+
+// with the mutex held
+Metrics::Series& Metrics::series(const std::string& name, const std::string& help, const char* type, const std::string& labels) {
+    Family* family = NULL;
+    for (size_t f = 0; f < families_m.size(); f++) {
+        if (families_m[f]->name == name) {
+            family = families_m[f];
+            break;
+        }
+    }
+    if (family == NULL) {
+        family = new Family;
+        family->name = name;
+        family->help = help;
+        family->type = type;
+        families_m.push_back(family);
+    } else if (strcmp(family->type, type) != 0) {
+        throw std::runtime_error(std::string("Metric ") + name + " is registered as a " + family->type);
+    }
+    for (size_t s = 0; s < family->series.size(); s++) {
+        if (family->series[s].labels == labels) return family->series[s];
+    }
+    Series ser;
+    ser.labels = labels;
+    ser.counter = NULL;
+    ser.gauge = NULL;
+    ser.histogram = NULL;
+    family->series.push_back(ser);
+    return family->series.back();
+}
+
+Metrics::Counter& Metrics::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    RInsideMutexLock lock(mutex_m);
+    Series& ser = series(name, help, "counter", labels);
+    if (ser.counter == NULL) ser.counter = new Counter;
+    return *ser.counter;
+}
+
+Metrics::Gauge& Metrics::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    RInsideMutexLock lock(mutex_m);
+    Series& ser = series(name, help, "gauge", labels);
+    if (ser.gauge == NULL) ser.gauge = new Gauge;
+    return *ser.gauge;
+}
+
+Metrics::Histogram& Metrics::histogram(const std::string& name, const std::string& help,
+                                       const std::vector<double>& bounds, const std::string& labels) {
+    RInsideMutexLock lock(mutex_m);
+    Series& ser = series(name, help, "histogram", labels);
+    if (ser.histogram == NULL) ser.histogram = new Histogram(bounds);
+    return *ser.histogram;
+}
+
+void Metrics::addCollector(Collector collector, void* arg) {
+    RInsideMutexLock lock(mutex_m);
+    collectors_m.push_back(std::make_pair(collector, arg));
+}
+
+std::vector<double> Metrics::exponentialBounds(double start, double factor, int count) {
+    std::vector<double> bounds;
+    for (int i = 0; i < count; i++, start *= factor) {
+        bounds.push_back(start);
+    }
+    return bounds;
+}
+
+void Metrics::appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+void Metrics::appendSample(std::string& out, const std::string& name, const std::string& labels, double value) {
+    out += name;
+    if (!labels.empty()) out += "{" + labels + "}";
+    out += " ";
+    appendNumber(out, value);
+    out += "\n";
+}
+
+void Metrics::appendHistogram(std::string& out, const std::string& name, const std::string& labels,
+                              const RInsideHistogram& hist, double scale) {
+    unsigned long cumulative = 0;
+    // every bucket, empty or not, so the series stay the same between scrapes;
+    // the last one is unbounded and covered by +Inf
+    for (int i = 0; i < RInsideHistogram::Buckets - 1; i++) {
+        cumulative += hist.bucketCount(i);
+        std::string le = "le=\"";
+        appendNumber(le, RInsideHistogram::bucketUpper(i) * scale);
+        appendSample(out, name + "_bucket", withLabel(labels, le + "\""), cumulative);
+    }
+    appendSample(out, name + "_bucket", withLabel(labels, "le=\"+Inf\""), hist.count());
+    appendSample(out, name + "_sum", labels, hist.sum() * scale);
+    appendSample(out, name + "_count", labels, hist.count());
+}
+
+std::string Metrics::renderPrometheus() {
+    std::string out;
+    RInsideMutexLock lock(mutex_m);
+    for (size_t f = 0; f < families_m.size(); f++) {
+        const Family& family = *families_m[f];
+        appendHeader(out, family.name, family.help, family.type);
+        for (size_t s = 0; s < family.series.size(); s++) {
+            const Series& ser = family.series[s];
+            if (ser.counter) {
+                appendSample(out, family.name, ser.labels, ser.counter->value());
+            } else if (ser.gauge) {
+                appendSample(out, family.name, ser.labels, ser.gauge->value());
+            } else if (ser.histogram) {
+                const Histogram& h = *ser.histogram;
+                std::vector<unsigned long> counts(h.bounds_m.size() + 1, 0);
+                double sum = 0;
+                for (int i = 0; i < Shards; i++) {
+                    for (size_t b = 0; b < counts.size(); b++) counts[b] += h.slots_m[i]->counts[b];
+                    sum += fromBits(h.slots_m[i]->sum);
+                }
+                unsigned long cumulative = 0;
+                for (size_t b = 0; b < counts.size(); b++) {
+                    cumulative += counts[b];
+                    std::string le = "le=\"";
+                    if (b < h.bounds_m.size()) {
+                        appendNumber(le, h.bounds_m[b]);
+                    } else {
+                        le += "+Inf";
+                    }
+                    appendSample(out, family.name + "_bucket", withLabel(ser.labels, le + "\""), cumulative);
+                }
+                appendSample(out, family.name + "_sum", ser.labels, sum);
+                appendSample(out, family.name + "_count", ser.labels, cumulative);
+            }
+        }
+    }
+    for (size_t c = 0; c < collectors_m.size(); c++) {
+        collectors_m[c].first(out, collectors_m[c].second);
+    }
+    return out;
+}
@@ -0,0 +1,332 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// ModelScorer.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+
+#include <RInside.h>
+#include <ModelScorer.h>
+#include <Timing.h>
+
+static const size_t MaxFrames = 8;      // batch sizes kept per model
+
+// R's message for the error just caught, without its trailing newline
+static std::string lastError() {
+    std::string buf(R_curErrorBuf());
+    return buf.substr(0, buf.find_last_not_of("\n") + 1);
+}
+
+void ModelScorer::Request::wait() {
+    if (scorer_m == NULL) return;       // never submitted
+    RInsideMutexLock lock(scorer_m->mutex_m);
+    while (!done_m) {
+        scorer_m->done_m.wait(scorer_m->mutex_m);
+    }
+}
+
+ModelScorer::ModelScorer(RInside& R, size_t maxBatch, long latencyUsec) :
+    R_m(R), maxBatch_m(maxBatch > 0 ? maxBatch : 1), latency_m(latencyUsec), next_m(0), shutdown_m(false) {
+}
+
+ModelScorer::~ModelScorer() {
+    while (!models_m.empty()) {
+        unloadModel(models_m.begin()->first);
+    }
+}
+
+int ModelScorer::loadModel(const std::string& expr, const Schema& schema, const std::string& args) {
+    SEXP model;
+    if (R_m.parseEval(expr, model) != 0) {
+        throw std::runtime_error(std::string("Error loading model: ") + expr + ": " + lastError());
+    }
+    return addModel(model, schema, args);
+}
+
+int ModelScorer::addModel(SEXP model, const Schema& schema, const std::string& args) {
+    PROTECT(model);                     // eg straight from parseEval(), and the parse allocates
+    // the only parse: predict() by the symbols the model's environment binds
+    std::string txt = "predict(.model, .newdata" + (args.empty() ? std::string("") : ", " + args) + ")";
+    ParseStatus status;
+    SEXP cmd = PROTECT(Rf_mkString(txt.c_str()));
+    SEXP expr = PROTECT(R_ParseVector(cmd, -1, &status, R_NilValue));
+    if (status != PARSE_OK || Rf_length(expr) != 1) {
+        UNPROTECT(3);
+        throw std::runtime_error(std::string("Could not parse predict() arguments: ") + args);
+    }
+    Model* m = new Model;
+    m->env = Rf_NewEnvironment(R_NilValue, R_NilValue, R_GlobalEnv);
+    R_PreserveObject(m->env);
+    Rf_defineVar(Rf_install(".model"), model, m->env);
+    m->schema = schema;
+    m->call = VECTOR_ELT(expr, 0);
+    R_PreserveObject(m->call);
+    UNPROTECT(3);
+    models_m[next_m] = m;
+    return next_m++;
+}
+
+void ModelScorer::unloadModel(int model) {
+    Model* m = find(model);
+    for (std::map<size_t, Frame>::iterator it = m->frames.begin(); it != m->frames.end(); ++it) {
+        R_ReleaseObject(it->second.data);
+    }
+    R_ReleaseObject(m->call);
+    R_ReleaseObject(m->env);
+    models_m.erase(model);
+    delete m;
+}
+
+ModelScorer::Model* ModelScorer::find(int model) {
+    std::map<int, Model*>::iterator it = models_m.find(model);
+    if (it == models_m.end()) {
+        throw std::runtime_error("Unknown model handle");
+    }
+    return it->second;
+}
+
+// newdata data.frame of 'nrows' rows, built on first use; of those built,
+// the MaxFrames used last are kept
+SEXP ModelScorer::frame(Model* m, size_t nrows) {
+    m->uses++;
+    std::map<size_t, Frame>::iterator it = m->frames.find(nrows);
+    if (it != m->frames.end()) {
+        it->second.used = m->uses;
+        return it->second.data;
+    }
+    if (m->frames.size() >= MaxFrames) {
+        std::map<size_t, Frame>::iterator oldest = m->frames.begin();
+        for (it = m->frames.begin(); it != m->frames.end(); ++it) {
+            if (it->second.used < oldest->second.used) oldest = it;
+        }
+        R_ReleaseObject(oldest->second.data);
+        m->frames.erase(oldest);
+    }
+    int ncol = m->schema.size();
+    SEXP df = PROTECT(Rf_allocVector(VECSXP, ncol));
+    SEXP names = PROTECT(Rf_allocVector(STRSXP, ncol));
+    for (int j = 0; j < ncol; j++) {
+        SET_VECTOR_ELT(df, j, Rf_allocVector(m->schema[j].type, nrows));
+        SET_STRING_ELT(names, j, Rf_mkChar(m->schema[j].name.c_str()));
+    }
+    Rf_setAttrib(df, R_NamesSymbol, names);
+    SEXP rownames = PROTECT(Rf_allocVector(INTSXP, 2)); // compact form c(NA, -nrows)
+    INTEGER(rownames)[0] = NA_INTEGER;
+    INTEGER(rownames)[1] = -static_cast<int>(nrows);
+    Rf_setAttrib(df, R_RowNamesSymbol, rownames);
+    Rf_setAttrib(df, R_ClassSymbol, Rf_mkString("data.frame"));
+    R_PreserveObject(df);
+    UNPROTECT(3);
+    Frame& f = m->frames[nrows];
+    f.data = df;
+    f.used = m->uses;
+    return df;
+}
+
+void ModelScorer::fill(Model* m, SEXP df, const std::vector<const void*>& columns, size_t nrows) {
+    for (size_t j = 0; j < m->schema.size(); j++) {
+        SEXP col = VECTOR_ELT(df, j);
+        switch (m->schema[j].type) {
+        case REALSXP:
+            memcpy(REAL(col), columns[j], nrows * sizeof(double));
+            break;
+        case INTSXP:
+            memcpy(INTEGER(col), columns[j], nrows * sizeof(int));
+            break;
+        case LGLSXP:
+            memcpy(LOGICAL(col), columns[j], nrows * sizeof(int));
+            break;
+        case STRSXP: {
+            const char* const* s = static_cast<const char* const*>(columns[j]);
+            for (size_t i = 0; i < nrows; i++) {
+                SET_STRING_ELT(col, i, Rf_mkChar(s[i]));
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error(std::string("Unsupported type of column ") + m->schema[j].name);
+        }
+    }
+}
+
+size_t ModelScorer::score(int model, const std::vector<const void*>& columns, size_t nrows, std::vector<double>& out) {
+    Model* m = find(model);
+    if (columns.size() != m->schema.size()) {
+        throw std::runtime_error("Number of columns does not match the model schema");
+    }
+    SEXP df = frame(m, nrows);
+    fill(m, df, columns, nrows);
+    Rf_defineVar(Rf_install(".newdata"), df, m->env);
+
+    int errorOccurred;
+    SEXP res = PROTECT(R_tryEval(m->call, m->env, &errorOccurred));
+    if (errorOccurred) {
+        UNPROTECT(1);
+        throw std::runtime_error("Error evaluating predict(): " + lastError());
+    }
+    size_t n = Rf_xlength(res);
+    out.resize(n);
+    switch (TYPEOF(res)) {
+    case REALSXP:
+        std::copy(REAL(res), REAL(res) + n, out.begin());
+        break;
+    case INTSXP:
+    case LGLSXP:
+        for (size_t i = 0; i < n; i++) {
+            int v = INTEGER(res)[i];
+            out[i] = (v == NA_INTEGER) ? NA_REAL : v;
+        }
+        break;
+    default:
+        UNPROTECT(1);
+        throw std::runtime_error("predict() did not return a numeric result");
+    }
+    UNPROTECT(1);
+    return nrows > 0 ? n / nrows : 0;
+}
+
+void ModelScorer::submit(Request* request) {
+    RInsideMutexLock lock(mutex_m);
+    request->scorer_m = this;
+    request->done_m = false;
+    request->error_m.clear();
+    request->arrival_m = monotonicUsec();
+    pending_m.push_back(request);
+    queued_m.signal();
+}
+
+// requests are taken in arrival order; a batch holds the oldest request
+// plus the following ones for the same model
+void ModelScorer::serve() {
+    for (;;) {
+        std::vector<Request*> batch;
+        {
+            RInsideMutexLock lock(mutex_m);
+            while (pending_m.empty() && !shutdown_m) {
+                queued_m.wait(mutex_m);
+            }
+            if (pending_m.empty()) return;
+            while (!shutdown_m && pending_m.size() < maxBatch_m) {
+                double left = pending_m.front()->arrival_m + latency_m - monotonicUsec();
+                if (left <= 0) break;
+                queued_m.wait(mutex_m, static_cast<long>(left));
+            }
+            int model = pending_m.front()->model_m;
+            std::deque<Request*>::iterator it = pending_m.begin();
+            while (it != pending_m.end() && batch.size() < maxBatch_m) {
+                if ((*it)->model_m == model) {
+                    batch.push_back(*it);
+                    it = pending_m.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        scoreBatch(batch);
+    }
+}
+
+void ModelScorer::flush() {
+    for (;;) {
+        std::vector<Request*> batch;
+        {
+            RInsideMutexLock lock(mutex_m);
+            if (pending_m.empty()) return;
+            int model = pending_m.front()->model_m;
+            std::deque<Request*>::iterator it = pending_m.begin();
+            while (it != pending_m.end() && batch.size() < maxBatch_m) {
+                if ((*it)->model_m == model) {
+                    batch.push_back(*it);
+                    it = pending_m.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        scoreBatch(batch);
+    }
+}
+
+void ModelScorer::shutdown() {
+    RInsideMutexLock lock(mutex_m);
+    shutdown_m = true;
+    queued_m.broadcast();
+}
+
+void ModelScorer::scoreBatch(std::vector<Request*>& batch) {
+    size_t n = batch.size();
+    try {
+        Model* m = find(batch[0]->model_m);
+        size_t nnum = 0, nstr = 0;
+        for (size_t j = 0; j < m->schema.size(); j++) {
+            if (m->schema[j].type == STRSXP) nstr++; else nnum++;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i]->values.size() != nnum || batch[i]->strings.size() != nstr) {
+                throw std::runtime_error("Request does not match the model schema");
+            }
+        }
+        // transpose the rows into columns of the types the schema asks for
+        std::vector<double> dbuf(n * nnum);
+        std::vector<int> ibuf(n * nnum);
+        std::vector<const char*> sbuf(n * nstr);
+        std::vector<const void*> columns(m->schema.size());
+        size_t knum = 0, kstr = 0;
+        for (size_t j = 0; j < m->schema.size(); j++) {
+            if (m->schema[j].type == STRSXP) {
+                for (size_t i = 0; i < n; i++) sbuf[kstr * n + i] = batch[i]->strings[kstr].c_str();
+                columns[j] = &sbuf[kstr * n];
+                kstr++;
+            } else if (m->schema[j].type == REALSXP) {
+                for (size_t i = 0; i < n; i++) dbuf[knum * n + i] = batch[i]->values[knum];
+                columns[j] = &dbuf[knum * n];
+                knum++;
+            } else {                    // NA as as.integer() has it for NaN and out of range
+                for (size_t i = 0; i < n; i++) {
+                    double v = batch[i]->values[knum];
+                    ibuf[knum * n + i] = (ISNAN(v) || v >= 2147483648.0 || v <= -2147483649.0) ? NA_INTEGER : static_cast<int>(v);
+                }
+                columns[j] = &ibuf[knum * n];
+                knum++;
+            }
+        }
+        std::vector<double> out;
+        size_t k = score(batch[0]->model_m, columns, n, out);
+        for (size_t i = 0; i < n; i++) {
+            batch[i]->result_m.resize(k);
+            for (size_t c = 0; c < k; c++) {
+                batch[i]->result_m[c] = out[c * n + i];
+            }
+        }
+    } catch (const std::exception& ex) {
+        for (size_t i = 0; i < n; i++) {
+            batch[i]->error_m = ex.what();
+        }
+    }
+    complete(batch);
+}
+
+void ModelScorer::complete(std::vector<Request*>& batch) {
+    RInsideMutexLock lock(mutex_m);
+    for (size_t i = 0; i < batch.size(); i++) {
+        batch[i]->done_m = true;
+    }
+    done_m.broadcast();
+}
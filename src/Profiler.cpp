@@ -0,0 +1,258 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Profiler.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <RInside.h>
+#include <Profiler.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef WIN32
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+RInsideProfiler::RInsideProfiler(const std::string& dir) : path_m(dir + "/Rprof.fifo"), running_m(false),
+                                             lastBytes_m(-1), start_m(0) {
+#ifndef WIN32
+    unlink(path_m.c_str());             // left over from a run that was cut short
+    if (mkfifo(path_m.c_str(), 0600) != 0) {
+        throw std::runtime_error(std::string("Could not create ") + path_m + ": " + strerror(errno));
+    }
+#else
+    throw std::runtime_error("The profiler needs a FIFO, which is not available on Windows");
+#endif
+}
+
+RInsideProfiler::~RInsideProfiler() {
+    if (running_m) {
+        abandon();
+    }
+#ifndef WIN32
+    unlink(path_m.c_str());
+#endif
+}
+
+void RInsideProfiler::start() {
+    start_m = monotonicUsec();
+    if (pthread_create(&reader_m, NULL, readerMain, this) != 0) {
+        throw std::runtime_error("Could not start the profile reader thread");
+    }
+    running_m = true;
+}
+
+// the reader waits in fopen() for a writer; be that writer, briefly
+void RInsideProfiler::abandon() {
+#ifndef WIN32
+    for (int i = 0; i < 1000; i++) {
+        int fd = open(path_m.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd >= 0) {
+            close(fd);
+            break;
+        }
+        usleep(1000);                   // the reader has not opened its end yet
+    }
+#endif
+    pthread_join(reader_m, NULL);
+    running_m = false;
+}
+
+namespace {
+    bool moreSamples(const RInsideProfileEntry& a, const RInsideProfileEntry& b) {
+        return a.totalSamples > b.totalSamples ||
+            (a.totalSamples == b.totalSamples && a.selfSamples > b.selfSamples);
+    }
+}
+
+RInsideProfile RInsideProfiler::finish() {
+    pthread_join(reader_m, NULL);
+    running_m = false;
+    RInsideProfile profile = profile_m;
+    for (std::map<std::string, Counts>::const_iterator it = counts_m.begin(); it != counts_m.end(); ++it) {
+        RInsideProfileEntry entry;
+        entry.name = it->first;
+        entry.selfSamples = it->second.self;
+        entry.totalSamples = it->second.total;
+        entry.selfBytes = it->second.selfBytes;
+        entry.totalBytes = it->second.totalBytes;
+        profile.functions.push_back(entry);
+    }
+    std::sort(profile.functions.begin(), profile.functions.end(), moreSamples);
+    return profile;
+}
+
+void* RInsideProfiler::readerMain(void* self) {
+    static_cast<RInsideProfiler*>(self)->read();
+    return NULL;
+}
+
+void RInsideProfiler::read() {
+#ifndef WIN32
+    sigset_t prof;                      // R's SIGPROF handler belongs on the R thread, and
+    sigemptyset(&prof);                 // would cut our reads short here
+    sigaddset(&prof, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &prof, NULL);
+#endif
+    FILE* fp = fopen(path_m.c_str(), "r");  // returns once Rprof() has opened the other end
+    if (fp == NULL) return;
+    if (RInsideTrace::enabled()) RInsideTrace::setThreadName("R profile");
+    char buf[4096];
+    std::string line;
+    while (fgets(buf, sizeof(buf), fp)) {
+        line += buf;
+        if (line[line.size() - 1] == '\n') {
+            line.erase(line.size() - 1);
+            sample(line);
+            line.clear();
+        }
+    }
+    if (!line.empty()) sample(line);
+    fclose(fp);
+    traceStack(std::vector<std::string>(), start_m + profile_m.samples * profile_m.interval * 1e6);
+}
+
+// one line of Rprof() output: a header naming the interval, or the stack
+// at a sample, innermost function first, each name quoted, preceded by
+// ":small:big:nodes:duplicates:" with memory profiling
+void RInsideProfiler::sample(const std::string& line) {
+    size_t pos = line.find("sample.interval=");
+    if (pos != std::string::npos) {
+        profile_m.interval = atof(line.c_str() + pos + 16) * 1e-6;
+        return;
+    }
+    if (line.empty() || line[0] == '#') {
+        return;
+    }
+    double delta = 0;
+    pos = 0;
+    if (line[0] == ':') {
+        double small, big, nodes;
+        if (sscanf(line.c_str(), ":%lf:%lf:%lf:", &small, &big, &nodes) == 3) {
+            double bytes = (small + big) * 8 + nodes * 56;      // vector cells and cons cells
+            if (lastBytes_m >= 0 && bytes > lastBytes_m) delta = bytes - lastBytes_m;
+            lastBytes_m = bytes;
+        }
+        for (int colons = 0; pos < line.size() && colons < 5; pos++) {
+            if (line[pos] == ':') colons++;
+        }
+    }
+
+    std::vector<std::string> stack;
+    while ((pos = line.find('"', pos)) != std::string::npos) {
+        size_t end = line.find('"', pos + 1);
+        if (end == std::string::npos) break;
+        stack.push_back(line.substr(pos + 1, end - pos - 1));
+        pos = end + 1;
+    }
+
+    profile_m.samples++;
+    profile_m.bytes += delta;
+    for (size_t i = 0; i < stack.size(); i++) {
+        if (std::find(stack.begin(), stack.begin() + i, stack[i]) != stack.begin() + i) {
+            continue;                   // recursion counts once
+        }
+        Counts& c = counts_m[stack[i]];
+        if (i == 0) {
+            c.self++;
+            c.selfBytes += delta;
+        }
+        c.total++;
+        c.totalBytes += delta;
+    }
+
+    if (RInsideTrace::enabled()) {
+        std::reverse(stack.begin(), stack.end());
+        traceStack(stack, start_m + (profile_m.samples - 1) * profile_m.interval * 1e6);
+    }
+}
+
+// closes the spans of frames no longer on the stack and opens the new ones;
+// times are those at which samples were due rather than when they arrive
+void RInsideProfiler::traceStack(const std::vector<std::string>& stack, double now) {
+    size_t common = 0;
+    while (common < stack.size() && common < open_m.size() && stack[common] == open_m[common]) {
+        common++;
+    }
+    while (open_m.size() > common) {
+        RInsideTrace::record("R", open_m.back().c_str(), opened_m.back(), now - opened_m.back());
+        open_m.pop_back();
+        opened_m.pop_back();
+    }
+    for (size_t i = common; i < stack.size(); i++) {
+        open_m.push_back(stack[i]);
+        opened_m.push_back(now);
+    }
+}
+
+void RInside::startProfiler(double interval, bool memory) {
+    if (profiler_m) {
+        throw std::runtime_error("The profiler is already running");
+    }
+    profiler_m = new RInsideProfiler(tempDir());
+    profiler_m->start();
+    // built rather than parsed, so the path needs no quoting
+    SEXP fun = PROTECT(Rf_lang3(R_DoubleColonSymbol, Rf_install("utils"), Rf_install("Rprof")));
+    SEXP path = PROTECT(Rf_mkString(profiler_m->path().c_str()));
+    SEXP secs = PROTECT(Rf_ScalarReal(interval));
+    SEXP mem = PROTECT(Rf_ScalarLogical(memory));
+    SEXP gc = PROTECT(Rf_ScalarLogical(TRUE));
+    SEXP call = PROTECT(Rf_lang5(fun, path, secs, mem, gc));
+    SET_TAG(CDDR(call), Rf_install("interval"));
+    SET_TAG(CDR(CDDR(call)), Rf_install("memory.profiling"));
+    SET_TAG(CDDR(CDDR(call)), Rf_install("gc.profiling"));
+    int errorOccurred;
+    R_tryEval(call, R_GlobalEnv, &errorOccurred);
+    UNPROTECT(6);
+    if (errorOccurred) {
+        profiler_m->abandon();
+        delete profiler_m;
+        profiler_m = NULL;
+        throw std::runtime_error("Could not start R's profiler");
+    }
+}
+
+RInsideProfile RInside::stopProfiler() {
+    if (profiler_m == NULL) {
+        throw std::runtime_error("The profiler is not running");
+    }
+    SEXP ans;
+    parseEvalEnv("utils::Rprof(NULL)", ans, R_GlobalEnv, 0, false);  // closes the FIFO, the reader sees its end
+    RInsideProfile profile = profiler_m->finish();
+    delete profiler_m;
+    profiler_m = NULL;
+    return profile;
+}
+
+RInsideProfile RInside::profile(const std::string & line, double interval, bool memory) {
+    startProfiler(interval, memory);
+    SEXP ans;
+    int rc = parseEval(line, ans);
+    RInsideProfile profile = stopProfiler();
+    if (rc != 0) {
+        throw std::runtime_error(errorMessage(line));
+    }
+    return profile;
+}
@@ -20,6 +20,8 @@
 // You should have received a copy of the GNU General Public License
 // along with RInside.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+
 #include <RInside.h>
 #include <Callbacks.h>
 
@@ -34,15 +36,26 @@ const char *programName = "RInside";
 #endif
 
 RInside::~RInside() {           // now empty as MemBuf is internal
+    if (profiler_m) {
+        try {
+            stopProfiler();
+        } catch (std::exception& ex) {  // nothing to report it to
+        }
+    }
+    releaseSnapshots();
+    dropSessions();
+    R_ReleaseObject(baseline_m);
     R_dot_Last();
     R_RunExitFinalizers();
-    R_CleanTempDir();
+    R_CleanTempDir();                   // a no-op as we set R_TempDir, see init_tempdir()
+    removeTempDir();
     //Rf_KillAllDevices();
     //#ifndef WIN32
     //fpu_setup(FALSE);
     //#endif
     Rf_endEmbeddedR(0);
     instance_m = 0 ;
+    delete counters_m;
     delete global_env_m;
 }
 
@@ -51,7 +64,7 @@ RInside::RInside(): global_env_m(NULL)
     , callbacks(0)
 #endif
 {
-    initialize(0, 0, false, false, false);
+    initialize(0, 0, Options());
 }
 
 #ifdef WIN32
@@ -94,12 +107,22 @@ RInside::RInside(const int argc, const char* const argv[], const bool loadRcpp,
     		: callbacks(0)
 #endif
 {
-    initialize(argc, argv, loadRcpp, verbose, interactive);
+    Options options;                    // Rcpp is always loaded here, see Options::loadRcpp
+    options.verbose = verbose;
+    options.interactive = interactive;
+    initialize(argc, argv, options);
+}
+
+RInside::RInside(const int argc, const char* const argv[], const Options& options)
+#ifdef RINSIDE_CALLBACKS
+    		: callbacks(0)
+#endif
+{
+    initialize(argc, argv, options);
 }
 
 // TODO: use a vector<string> would make all this a bit more readable
-void RInside::initialize(const int argc, const char* const argv[], const bool loadRcpp, 
-                         const bool verbose, const bool interactive) {
+void RInside::initialize(const int argc, const char* const argv[], const Options& options) {
 
     if (instance_m) {
         throw std::runtime_error( "can only have one RInside instance" ) ;
@@ -107,8 +130,37 @@ void RInside::initialize(const int argc, const char* const argv[], const bool lo
         instance_m = this ;
     }
 
-    verbose_m = verbose;          	// Default is false
-    interactive_m = interactive;
+    verbose_m = options.verbose;    	// Default is false
+    interactive_m = options.interactive;
+    r_thread_m = pthread_self();
+    queue_m = NULL;
+    autoloads_pending_m = false;
+    global_env_m = NULL;
+    rcpp_loaded_m = false;
+    session_clock_m = 0;
+    session_limit_m = 0;
+    memory_accounting_m = false;
+    eval_budget_m = 0;
+    eval_depth_m = 0;
+    mem_reset_call_m = mem_peak_call_m = NULL;
+    gc_telemetry_m = false;
+    gc_info_prev_m = 0;
+    gc_time_call_m = NULL;
+    gc_elapsed_m = 0.0;
+    console_routed_m = false;
+    console_out_m = console_err_m = NULL;
+    console_prev_m = NULL;
+    console_prev_plain_m = NULL;
+    capture_m = NULL;
+    capture_messages_m = false;
+    condition_sink_m = NULL;
+    condition_wrapper_m = NULL;
+    profiler_m = NULL;
+    counters_m = NULL;
+    init_metrics();
+    startup_m.clear();
+    phase_start_m = monotonicUsec();
+    phase_rss_m = residentKb();
 
     // generated from Makevars{.win}
     #include "RInsideEnvVars.h"
@@ -135,22 +187,48 @@ void RInside::initialize(const int argc, const char* const argv[], const bool lo
         }
     }
 
+    // which packages R attaches at startup, and hence which we autoload below
+    autoload_all_m = options.defaultPackages.empty();
+    autoload_packages_m.clear();
+    if (!autoload_all_m) {
+        if (setenv("R_DEFAULT_PACKAGES", options.defaultPackages.c_str(), 1) != 0) {
+            throw std::runtime_error(std::string("Could not set R_DEFAULT_PACKAGES to ") + options.defaultPackages);
+        }
+        if (options.defaultPackages != "NULL") {
+            std::string::size_type start = 0, end;
+            do {
+                end = options.defaultPackages.find(',', start);
+                std::string pkg = options.defaultPackages.substr(start, end == std::string::npos ? end : end - start);
+                pkg.erase(0, pkg.find_first_not_of(" \t"));
+                pkg.erase(pkg.find_last_not_of(" \t") + 1);
+                if (!pkg.empty()) autoload_packages_m.push_back(pkg);
+                start = end + 1;
+            } while (end != std::string::npos);
+        }
+    }
+
     #ifndef WIN32
     R_SignalHandlers = 0;               // Don't let R set up its own signal handlers
     #endif
 
-    init_tempdir();
+    temp_limit_m = options.tempLimit;
+    temp_exceeded_m = false;
+    temp_checked_m = 0.0;
+    init_tempdir(options.tempBase);
+    startupPhase("environment");
 
     const char *R_argv[] = {(char*)programName, "--gui=none", "--no-save", 
                             "--no-readline", "--silent", "--vanilla", "--slave"};
     int R_argc = sizeof(R_argv) / sizeof(R_argv[0]);
     Rf_initEmbeddedR(R_argc, (char**)R_argv);
+    startupPhase("initEmbeddedR");
 
     #ifndef WIN32
     R_CStackLimit = -1;      		// Don't do any stack checking, see R Exts, '8.1.5 Threading issues'
     #endif
 
     R_ReplDLLinit();                    // this is to populate the repl console buffers
+    startupPhase("ReplDLLinit");
 
     structRstart Rst;
     R_DefParams(&Rst);
@@ -166,47 +244,97 @@ void RInside::initialize(const int argc, const char* const argv[], const bool lo
     Rst.YesNoCancel = myAskYesNoCancel;
     Rst.Busy = myBusy;
     #endif
+    // R_DefParams() has the vector heap size in bytes, but R has set up its
+    // heap by now and keeps it in 8-byte cells, which is what R_SetParams()
+    // gets from here on
+    Rst.vsize /= sizeof(double);
+    if (options.vsize / sizeof(double) > Rst.vsize) Rst.vsize = options.vsize / sizeof(double);
+    if (options.nsize > Rst.nsize) Rst.nsize = options.nsize;
+    if (options.maxVSize) Rst.max_vsize = options.maxVSize;
+    if (options.maxNSize) Rst.max_nsize = options.maxNSize;
     R_SetParams(&Rst);
+    params_m = Rst;
+    routeConsole();                     // so that console output is counted, also without callbacks
+    startupPhase("SetParams");
 
-    if (true || loadRcpp) {             // we always need Rcpp, so load it anyway
-        // Rf_install is used best by first assigning like this so that symbols get into the symbol table
-        // where they cannot be garbage collected; doing it on the fly does expose a minuscule risk of garbage
-        // collection -- with thanks to Doug Bates for the explanation and Luke Tierney for the heads-up
-        SEXP suppressMessagesSymbol = Rf_install("suppressMessages");
-        SEXP requireSymbol = Rf_install("require");
-        Rf_eval(Rf_lang2(suppressMessagesSymbol, Rf_lang2(requireSymbol, Rf_mkString("Rcpp"))), R_GlobalEnv);
+    if (options.loadRcpp) {             // else deferred until something needs it
+        ensureRcpp();
     }
+    startupPhase("loadRcpp");
 
-    global_env_m = new Rcpp::Environment();         // member variable for access to R's global environment 
-
-    autoloads();                        // loads all default packages, using code autogenerate from Makevars{,.win}
+    if (options.deferAutoloads) {
+        defer_autoloads();              // set up on the first lookup miss instead
+    } else {
+        autoloads();                    // loads all default packages, using code autogenerate from Makevars{,.win}
+    }
+    startupPhase("autoloads");
 
     if ((argc - optind) > 1){           // for argv vector in Global Env */
-        Rcpp::CharacterVector s_argv( argv+(1+optind), argv+argc );
-        assign(s_argv, "argv");
+        SEXP s_argv = PROTECT(Rf_allocVector(STRSXP, argc - (1+optind)));
+        for (int i = 1+optind; i < argc; i++) {
+            SET_STRING_ELT(s_argv, i - (1+optind), Rf_mkChar(argv[i]));
+        }
+        Rf_defineVar(Rf_install("argv"), s_argv, R_GlobalEnv);
+        UNPROTECT(1);
     } else {
-        assign(R_NilValue, "argv") ;
+        Rf_defineVar(Rf_install("argv"), R_NilValue, R_GlobalEnv);
     }
 
     init_rand();                        // for tempfile() to work correctly */
+    init_baseline();
+    startupPhase("argv and init_rand");
+
+    if (getenv("RINSIDE_STARTUP_REPORT") != NULL) {
+        printStartupReport(std::cerr);
+    }
 }
 
-void RInside::init_tempdir(void) {
-    const char *tmp;
-    // FIXME:  if per-session temp directory is used (as R does) then return
-    tmp = getenv("TMPDIR");
-    if (tmp == NULL) {
-        tmp = getenv("TMP");
-        if (tmp == NULL) {
-            tmp = getenv("TEMP");
-            if (tmp == NULL)
-                tmp = "/tmp";
-            }
+// Rcpp's C++ API needs its package loaded, so everything using it comes here first
+void RInside::ensureRcpp() {
+    if (rcpp_loaded_m) return;
+    // Rf_install is used best by first assigning like this so that symbols get into the symbol table
+    // where they cannot be garbage collected; doing it on the fly does expose a minuscule risk of garbage
+    // collection -- with thanks to Doug Bates for the explanation and Luke Tierney for the heads-up
+    SEXP suppressMessagesSymbol = Rf_install("suppressMessages");
+    SEXP requireSymbol = Rf_install("require");
+    int errorOccurred;
+    R_tryEval(Rf_lang2(suppressMessagesSymbol, Rf_lang2(requireSymbol, Rf_mkString("Rcpp"))),
+              R_GlobalEnv, &errorOccurred);
+    if (errorOccurred) {
+        throw std::runtime_error("Could not load Rcpp");
     }
-    R_TempDir = (char*) tmp;
-    if (setenv("R_SESSION_TMPDIR",tmp,1) != 0){
-        throw std::runtime_error(std::string("Could not set / replace R_SESSION_TMPDIR to ") + std::string(tmp));
+    global_env_m = new Rcpp::Environment();         // member variable for access to R's global environment 
+    rcpp_loaded_m = true;
+}
+
+void RInside::startupPhase(const char* name) {
+    StartupPhase phase;
+    double now = monotonicUsec();
+    phase.name = name;
+    phase.usec = now - phase_start_m;
+    phase.rssKb = residentKb();
+    phase.rssDeltaKb = (phase.rssKb >= 0 && phase_rss_m >= 0) ? phase.rssKb - phase_rss_m : 0;
+    startup_m.push_back(phase);
+    phase_start_m = now;
+    phase_rss_m = phase.rssKb;
+}
+
+void RInside::printStartupReport(std::ostream& os) const {
+    double total = 0;
+    long totalRss = 0;
+    os << programName << " startup:" << std::endl;
+    for (size_t i = 0; i < startup_m.size(); i++) {
+        char line[128];
+        snprintf(line, sizeof(line), "  %-20s %10.0f usec  %+8ld kB  (rss %ld kB)",
+                 startup_m[i].name.c_str(), startup_m[i].usec,
+                 startup_m[i].rssDeltaKb, startup_m[i].rssKb);
+        os << line << std::endl;
+        total += startup_m[i].usec;
+        totalRss += startup_m[i].rssDeltaKb;
     }
+    char line[128];
+    snprintf(line, sizeof(line), "  %-20s %10.0f usec  %+8ld kB", "total", total, totalRss);
+    os << line << std::endl;
 }
 
 void RInside::init_rand(void) { 		// code borrows from R's TimeToSeed() in datetime.c
@@ -246,93 +374,174 @@ void RInside::autoloads() {
     // the list of packages, which by my code analysis is useless and only
     // for informational purposes.
     //
+    // Rather than evaluating a delayedAssign() call for each of the several
+    // thousand names, we create what it would create, directly:
     //
-
-    // we build the call :
-    //
-    //  delayedAssign( NAME,
-    //          autoloader( name = NAME, package = PACKAGE),
-    //          .GlobalEnv,
-    //          .AutoloadEnv )
-    //
-    //  where :
-    //  - PACKAGE is updated in a loop
-    //  - NAME is updated in a loop
-    //
+    //  NAME <- promise( autoloader( name = NAME, package = PACKAGE),
+    //                   eval.env = .GlobalEnv )
     //
+    // bound in .AutoloadEnv, in a single pass over the table of names
 
-    int i,j, idx=0, nobj ;
-    Rcpp::Language delayed_assign_call(Rcpp::Function("delayedAssign"),
-                                       R_NilValue,     // arg1: assigned in loop
-                                       R_NilValue,     // arg2: assigned in loop
-                                       *global_env_m,
-                                       global_env_m->find(".AutoloadEnv")
-                                       );
-    Rcpp::Language::Proxy delayed_assign_name  = delayed_assign_call[1];
-
-    Rcpp::Language autoloader_call(Rcpp::Function("autoloader"),
-                                   Rcpp::Named( "name", R_NilValue) ,  // arg1 : assigned in loop
-                                   Rcpp::Named( "package", R_NilValue) // arg2 : assigned in loop
-                                   );
-    Rcpp::Language::Proxy autoloader_name = autoloader_call[1];
-    Rcpp::Language::Proxy autoloader_pack = autoloader_call[2];
-    delayed_assign_call[2] = autoloader_call;
-
-    try {
-        for( i=0; i<packc; i++){
-
-            // set the 'package' argument of the autoloader call */
-            autoloader_pack = pack[i] ;
-
-            nobj = packobjc[i] ;
-            for (j = 0; j < nobj ; j++){
-
-                // set the 'name' argument of the autoloader call */
-                autoloader_name = packobj[idx+j] ;
-
-                // Set the 'name' argument of the delayedAssign call */
-                delayed_assign_name = packobj[idx+j] ;
-
-                // evaluate the call */
-                delayed_assign_call.eval() ;
+    SEXP autoloadEnv = Rf_findVar(Rf_install(".AutoloadEnv"), R_GlobalEnv);
+    if (TYPEOF(autoloadEnv) == PROMSXP) {
+        autoloadEnv = Rf_eval(autoloadEnv, R_GlobalEnv);
+    }
+    if (!Rf_isEnvironment(autoloadEnv)) {
+        throw std::runtime_error("Error setting up autoloads: no .AutoloadEnv");
+    }
+    PROTECT(autoloadEnv);
+    SEXP autoloaderSym = Rf_install("autoloader");
+    SEXP nameSym = Rf_install("name");
+    SEXP packageSym = Rf_install("package");
+
+    int idx = 0;
+    for (int i = 0; i < packc; i++) {
+        if (!autoload_all_m &&          // only those packages asked for in the Options
+            std::find(autoload_packages_m.begin(), autoload_packages_m.end(), pack[i]) == autoload_packages_m.end()) {
+            idx += packobjc[i];
+            continue;
+        }
+        SEXP package = PROTECT(Rf_mkString(pack[i]));   // shared by all calls for this package
+        for (int j = 0; j < packobjc[i]; j++) {
+            const char *name = packobj[idx+j];
+            SEXP nameStr = PROTECT(Rf_mkString(name));
+            SEXP call = PROTECT(Rf_lang3(autoloaderSym, nameStr, package));
+            SET_TAG(CDR(call), nameSym);
+            SET_TAG(CDDR(call), packageSym);
+            SEXP prom = PROTECT(Rf_mkPROMISE(call, R_GlobalEnv));
+            Rf_defineVar(Rf_install(name), prom, autoloadEnv);
+            UNPROTECT(3);
+        }
+        UNPROTECT(1);
+        idx += packobjc[i];
+    }
+    UNPROTECT(1);
+    autoloads_pending_m = false;
+}
 
+// A user-defined database (see R_ext/RObjectTables.h) attached just above
+// package:base.  Lookups only reach it once they have missed in the global
+// environment, every attached package and the (still empty) Autoloads
+// entry; the first one not also served by base sets up the autoloads, and
+// the table then answers from .AutoloadEnv so that this lookup succeeds as
+// well.  R's global cache keeps later lookups from coming here again.
+class AutoloadTable {
+public:
+    static Rboolean exists(const char * const name, Rboolean *canCache, R_ObjectTable *tb) {
+        *canCache = TRUE;
+        return (Rboolean) (lookup(name, tb) != R_UnboundValue);
+    }
+    static SEXP get(const char * const name, Rboolean *canCache, R_ObjectTable *tb) {
+        *canCache = TRUE;
+        return lookup(name, tb);
+    }
+    static int remove(const char * const name, R_ObjectTable *tb) {
+        return 0;
+    }
+    static SEXP assign(const char * const name, SEXP value, R_ObjectTable *tb) {
+        Rf_error("cannot assign into the RInside autoload table");
+        return R_NilValue;
+    }
+    static SEXP objects(R_ObjectTable *tb) {
+        return Rf_allocVector(STRSXP, 0);
+    }
+    static Rboolean canCache(const char * const name, R_ObjectTable *tb) {
+        return TRUE;
+    }
+private:
+    static SEXP lookup(const char * const name, R_ObjectTable *tb) {
+        RInside* R = static_cast<RInside*>(tb->privateData);
+        if (R->autoloads_pending_m) {
+            // base comes after us on the search path; its names are no miss
+            if (Rf_findVarInFrame(R_BaseEnv, Rf_install(name)) != R_UnboundValue) {
+                return R_UnboundValue;
             }
-            idx += packobjc[i] ;
+            R->autoloads_pending_m = false; // before, as setting up does lookups too
+            R->autoloads();
         }
-    } catch( std::exception& ex){
-        throw std::runtime_error(std::string("Error calling delayedAssign: ") + std::string(ex.what()));
+        SEXP env = Rf_findVar(Rf_install(".AutoloadEnv"), R_GlobalEnv);
+        if (!Rf_isEnvironment(env)) return R_UnboundValue;
+        return Rf_findVarInFrame(env, Rf_install(name));
+    }
+};
+
+void RInside::defer_autoloads() {
+    static R_ObjectTable table;
+    memset(&table, 0, sizeof(table));
+    table.active = TRUE;
+    table.exists = AutoloadTable::exists;
+    table.get = AutoloadTable::get;
+    table.remove = AutoloadTable::remove;
+    table.assign = AutoloadTable::assign;
+    table.objects = AutoloadTable::objects;
+    table.canCache = AutoloadTable::canCache;
+    table.privateData = this;
+
+    SEXP xp = PROTECT(R_MakeExternalPtr(&table, Rf_install("UserDefinedDatabase"), R_NilValue));
+    Rf_setAttrib(xp, R_ClassSymbol, Rf_mkString("UserDefinedDatabase"));
+    SEXP pos = PROTECT(Rf_eval(Rf_lang1(Rf_install("search")), R_GlobalEnv));
+    SEXP call = PROTECT(Rf_lang4(Rf_install("attach"), xp, Rf_ScalarInteger(Rf_length(pos)),
+                                 Rf_mkString("RInside:autoloads")));
+    SET_TAG(CDDR(call), Rf_install("pos"));
+    SET_TAG(CDR(CDDR(call)), Rf_install("name"));
+    int errorOccurred;
+    R_tryEval(call, R_GlobalEnv, &errorOccurred);
+    UNPROTECT(3);
+    if (errorOccurred) {                // fall back to doing it right away
+        autoloads();
+    } else {
+        autoloads_pending_m = true;
     }
 }
 
 // this is a non-throwing version returning an error code
 int RInside::parseEval(const std::string & line, SEXP & ans) {
+    return parseEvalEnv(line, ans, R_GlobalEnv, eval_budget_m);
+}
+
+// internal evaluations pass accounted = false, leaving the metrics, the
+// evaluation statistics and the memory accounting to user code
+int RInside::parseEvalEnv(const std::string & line, SEXP & ans, SEXP env, size_t budget, bool accounted) {
     ParseStatus status;
     SEXP cmdSexp, cmdexpr = R_NilValue;
-    int i, errorOccurred;
+    EvalStart start;
+    evalBegin(start, accounted);
 
+    releaseSnapshots();
     mb_m.add((char*)line.c_str());
 
     PROTECT(cmdSexp = Rf_allocVector(STRSXP, 1));
     SET_STRING_ELT(cmdSexp, 0, Rf_mkChar(mb_m.getBufPtr()));
 
     cmdexpr = PROTECT(R_ParseVector(cmdSexp, -1, &status, R_NilValue));
+    if (RInsideTrace::enabled()) RInsideTrace::record("rinside", "parse", start.usec, monotonicUsec() - start.usec);
 
     switch (status){
     case PARSE_OK:
-        // Loop is needed here as EXPSEXP might be of length > 1
-        for(i = 0; i < Rf_length(cmdexpr); i++){
-            ans = R_tryEval(VECTOR_ELT(cmdexpr, i), *global_env_m, &errorOccurred);
-            if (errorOccurred) {
-                if (verbose_m) Rf_warning("%s: Error in evaluating R code (%d)\n", programName, status);
-                UNPROTECT(2);
-                mb_m.rewind();
-                return 1;
-            }
-            if (verbose_m) {
-                Rf_PrintValue(ans);
-            }
-        }
+        // the buffer is no longer needed, and rewinding it before evaluation lets
+        // nested calls (e.g. from an event handler while R is busy) start afresh
         mb_m.rewind();
+        eval_depth_m++;
+        MemoryMark mark;
+        if (accounted) {
+            memoryBegin(mark, budget);
+        } else {
+            mark.active = mark.limited = false;
+        }
+        if (evalExpressions(cmdexpr, env, ans) != 0) {
+            if (verbose_m) Rf_warning("%s: Error in evaluating R code (%d)\n", programName, status);
+            memoryEnd(mark, true);
+            eval_depth_m--;
+            UNPROTECT(2);
+            return evalDone(start, 1);
+        }
+        PROTECT(ans);                   // measuring runs the collector
+        memoryEnd(mark, false);
+        UNPROTECT(1);
+        eval_depth_m--;
+        if (temp_limit_m && eval_depth_m == 0) {
+            checkTempLimit();
+        }
         break;
     case PARSE_INCOMPLETE:
         // need to read another line
@@ -341,13 +550,13 @@ int RInside::parseEval(const std::string & line, SEXP & ans) {
         if (verbose_m) Rf_warning("%s: ParseStatus is null (%d)\n", programName, status);
         UNPROTECT(2);
         mb_m.rewind();
-        return 1;
+        return evalDone(start, 1);
         break;
     case PARSE_ERROR:
         if (verbose_m) Rf_warning("Parse Error: \"%s\"\n", line.c_str());
         UNPROTECT(2);
         mb_m.rewind();
-        return 1;
+        return evalDone(start, 1);
         break;
     case PARSE_EOF:
         if (verbose_m) Rf_warning("%s: ParseStatus is eof (%d)\n", programName, status);
@@ -356,18 +565,272 @@ int RInside::parseEval(const std::string & line, SEXP & ans) {
         if (verbose_m) Rf_warning("%s: ParseStatus is not documented %d\n", programName, status);
         UNPROTECT(2);
         mb_m.rewind();
-        return 1;
+        return evalDone(start, 1);
         break;
     }
     UNPROTECT(2);
+    return evalDone(start, 0);
+}
+
+// evaluates the parsed expressions in turn, stopping at the first error
+int RInside::evalExpressions(SEXP cmdexpr, SEXP env, SEXP & ans) {
+    RInsideTraceSpan span("rinside", "eval");
+    int errorOccurred;
+    // Loop is needed here as EXPSEXP might be of length > 1
+    for (int i = 0; i < Rf_length(cmdexpr); i++) {
+        if (i > 0 && queue_m) {         // natural yield point for more urgent queued work
+            queue_m->yieldPoint();
+        }
+        if (condition_sink_m) {         // only then pay for the handlers
+            SEXP call = PROTECT(Rf_lang2(condition_wrapper_m, VECTOR_ELT(cmdexpr, i)));
+            ans = R_tryEval(call, env, &errorOccurred);
+            UNPROTECT(1);
+        } else {
+            ans = R_tryEval(VECTOR_ELT(cmdexpr, i), env, &errorOccurred);
+        }
+        if (errorOccurred) {
+            return 1;
+        }
+        if (verbose_m) {
+            Rf_PrintValue(ans);
+        }
+    }
     return 0;
 }
 
+void RInside::evalBegin(EvalStart& start, bool accounted) {
+    start.accounted = accounted;
+    start.counted = accounted && counters_m != NULL;
+    if (start.counted) {
+        counters_m->read(start.counters);
+    }
+    start.usec = monotonicUsec();
+}
+
+int RInside::evalDone(const EvalStart& start, int rc) {
+    if (!start.accounted) return rc;
+    double usec = monotonicUsec() - start.usec;
+    CounterValues now;
+    if (start.counted && counters_m) {
+        counters_m->read(now);
+    }
+    m_evals_m->inc();
+    if (rc != 0) m_errors_m->inc();
+    m_latency_m->observe(usec * 1e-6);
+    RInsideMutexLock lock(stats_mutex_m);
+    eval_stats_m.calls++;
+    if (rc != 0) eval_stats_m.errors++;
+    eval_stats_m.latencyUsec.add(usec);
+    if (start.counted && counters_m) {
+        eval_stats_m.counted++;
+        if (counters_m->hardware()) {
+            eval_stats_m.hardwareCounted++;
+            eval_stats_m.cycles.add(now.cycles - start.counters.cycles);
+            eval_stats_m.instructions.add(now.instructions - start.counters.instructions);
+            eval_stats_m.cacheMisses.add(now.cacheMisses - start.counters.cacheMisses);
+        }
+        eval_stats_m.contextSwitches.add(now.contextSwitches - start.counters.contextSwitches);
+        eval_stats_m.cpuUsec.add(now.cpuUsec - start.counters.cpuUsec);
+        eval_stats_m.pageFaults.add(now.pageFaults - start.counters.pageFaults);
+    }
+    return rc;
+}
+
+void RInside::init_metrics(void) {
+    m_evals_m = &metrics_m.counter("rinside_evaluations_total", "Calls of parseEval() and friends.");
+    m_errors_m = &metrics_m.counter("rinside_evaluation_errors_total", "Calls that failed to parse or evaluate.");
+    m_latency_m = &metrics_m.histogram("rinside_evaluation_seconds", "Wall time per call, including parsing.",
+                                       Metrics::exponentialBounds(1e-5, 4, 10));
+    const char* streams[] = { "stream=\"stdout\"", "stream=\"stderr\"" };
+    const char* directions[] = { "direction=\"from_r\"", "direction=\"to_r\"" };
+    for (int i = 0; i < 2; i++) {
+        m_console_m[i] = &metrics_m.counter("rinside_console_bytes_total",
+                                            "Console output passed through RInside.", streams[i]);
+        m_conversions_m[i] = &metrics_m.counter("rinside_conversions_total",
+                                                "Proxy and assign() conversions.", directions[i]);
+        m_conversion_bytes_m[i] = &metrics_m.counter("rinside_conversion_bytes_total",
+                                                     "Estimated size of the R objects converted.", directions[i]);
+    }
+    metrics_m.addCollector(collectMetrics, this);
+}
+
+// what is kept elsewhere already, read when rendering
+void RInside::collectMetrics(std::string& out, void* arg) {
+    RInside* R = static_cast<RInside*>(arg);
+    WorkQueue* queue = R->queue_m;
+    Metrics::appendHeader(out, "rinside_queue_depth", "Jobs waiting in the work queue.", "gauge");
+    Metrics::appendSample(out, "rinside_queue_depth", "", queue ? queue->depth() : 0);
+
+    RInsideMutexLock lock(R->stats_mutex_m);
+    const GcStats& gc = R->gc_stats_m;
+    if (!R->gc_telemetry_m && gc.collections == 0) {
+        return;                         // nothing known without setGcTelemetry(true)
+    }
+    Metrics::appendHeader(out, "rinside_gc_collections_total", "Garbage collections by generation.", "counter");
+    for (int i = 0; i < GcStats::Levels; i++) {
+        char level[16];
+        snprintf(level, sizeof(level), "level=\"%d\"", i);
+        Metrics::appendSample(out, "rinside_gc_collections_total", level, gc.byLevel[i]);
+    }
+    Metrics::appendHeader(out, "rinside_gc_pause_seconds", "Pause per garbage collection.", "histogram");
+    Metrics::appendHistogram(out, "rinside_gc_pause_seconds", "", gc.pauseUsec, 1e-6);
+    Metrics::appendHeader(out, "rinside_r_heap_bytes", "R heap after the last collection.", "gauge");
+    Metrics::appendSample(out, "rinside_r_heap_bytes", "space=\"cons\",kind=\"used\"", gc.consBytes);
+    Metrics::appendSample(out, "rinside_r_heap_bytes", "space=\"cons\",kind=\"size\"", gc.consHeapBytes);
+    Metrics::appendSample(out, "rinside_r_heap_bytes", "space=\"vector\",kind=\"used\"", gc.vectorBytes);
+    Metrics::appendSample(out, "rinside_r_heap_bytes", "space=\"vector\",kind=\"size\"", gc.vectorHeapBytes);
+}
+
+Metrics& RInside::metrics() {
+    return metrics_m;
+}
+
+std::string RInside::renderPrometheus() {
+    return metrics_m.renderPrometheus();
+}
+
+void RInside::countConsole(int len, int otype) {
+    m_console_m[otype != 0]->inc(len);
+}
+
+// length times element size, without walking any elements: strings and
+// lists count their pointers only, so this stays O(1) on every conversion
+static double conversionBytes(SEXP x) {
+    switch (TYPEOF(x)) {
+    case LGLSXP:
+    case INTSXP:  return Rf_xlength(x) * sizeof(int);
+    case REALSXP: return Rf_xlength(x) * sizeof(double);
+    case CPLXSXP: return Rf_xlength(x) * sizeof(Rcomplex);
+    case RAWSXP:  return Rf_xlength(x);
+    case STRSXP:
+    case VECSXP:  return Rf_xlength(x) * sizeof(SEXP);
+    default:      return 0;
+    }
+}
+
+void RInside::countConversion(SEXP x, bool toR) {
+    if (instance_m == NULL) return;
+    instance_m->m_conversions_m[toR]->inc();
+    instance_m->m_conversion_bytes_m[toR]->inc((unsigned long) conversionBytes(x));
+}
+
+void RInside::setEvalCounters(bool on) {
+    if (on && counters_m == NULL) {
+        counters_m = new EvalCounters;  // counts the thread it is made on, which must be R's
+        if (verbose_m && !counters_m->hardware()) {
+            Rf_warning("%s: No hardware counters, only OS counts will be kept\n", programName);
+        }
+    } else if (!on && counters_m) {
+        delete counters_m;
+        counters_m = NULL;
+    }
+}
+
+std::string RInside::errorMessage(const std::string & line) {
+    if (last_memory_m.budgetExceeded) {
+        return std::string("Memory budget exceeded evaluating: ") + line;
+    }
+    return std::string("Error evaluating: ") + line;
+}
+
+// gc() at R level is the only source for the heap in use; its 'max used'
+// is updated at the start of every collection, before anything is freed
+bool RInside::gcCells(SEXP call, double cells[4]) {
+    int errorOccurred;
+    SEXP res = R_tryEvalSilent(call, R_BaseEnv, &errorOccurred);
+    if (errorOccurred || TYPEOF(res) != REALSXP || Rf_length(res) != 4) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) cells[i] = REAL(res)[i];   // used N, V; max used N, V
+    return true;
+}
+
+// mem.maxVSize() in Mb or mem.maxNSize() in cells, Inf for no limit; set
+// first if given, which R refuses below what the heap holds already
+static bool memMax(const char* fun, double& value, double set = 0) {
+    SEXP arg = PROTECT(Rf_ScalarReal(set));
+    SEXP call = PROTECT(Rf_lang2(Rf_install(fun), arg));
+    int errorOccurred;
+    SEXP res = R_tryEvalSilent(call, R_BaseEnv, &errorOccurred);
+    bool ok = !errorOccurred && TYPEOF(res) == REALSXP && Rf_length(res) == 1;
+    if (ok) value = REAL(res)[0];
+    UNPROTECT(2);
+    return ok;
+}
+
+static const double ConsCellBytes = 56.0;   // sizeof(SEXPREC) on 64-bit builds
+
+void RInside::memoryBegin(MemoryMark& mark, size_t budget) {
+    mark.active = mark.limited = false;
+    mark.budget = budget;
+    last_memory_m = EvalMemory();
+    if (eval_depth_m > 1 || !(memory_accounting_m || budget)) {
+        return;
+    }
+    if (mem_reset_call_m == NULL) {
+        ParseStatus status;
+        SEXP code = PROTECT(Rf_allocVector(STRSXP, 2));
+        SET_STRING_ELT(code, 0, Rf_mkChar("c(gc(reset = TRUE, full = FALSE)[, c('used', 'max used')])"));
+        SET_STRING_ELT(code, 1, Rf_mkChar("c(gc(full = FALSE)[, c('used', 'max used')])"));
+        SEXP calls = PROTECT(R_ParseVector(code, -1, &status, R_NilValue));
+        mem_reset_call_m = VECTOR_ELT(calls, 0);
+        mem_peak_call_m = VECTOR_ELT(calls, 1);
+        R_PreserveObject(mem_reset_call_m);
+        R_PreserveObject(mem_peak_call_m);
+        UNPROTECT(2);
+    }
+    double cells[4];
+    if (!gcCells(mem_reset_call_m, cells)) {
+        return;
+    }
+    mark.active = true;
+    mark.ncells = cells[0];
+    mark.vcells = cells[1];
+    // through mem.maxVSize() and mem.maxNSize(), which unlike the C level
+    // also take Inf to lift a limit again
+    mark.limited = budget && memMax("mem.maxVSize", mark.maxVSize) && memMax("mem.maxNSize", mark.maxNSize);
+    if (mark.limited) {
+        double vlimit = (mark.vcells * sizeof(double) + budget) / 1048576.0;
+        double nlimit = mark.ncells + budget / ConsCellBytes;
+        double now;
+        if (vlimit < mark.maxVSize) memMax("mem.maxVSize", now, vlimit);
+        if (nlimit < mark.maxNSize) memMax("mem.maxNSize", now, nlimit);
+    }
+}
+
+void RInside::memoryEnd(const MemoryMark& mark, bool failed) {
+    if (!mark.active) {
+        return;
+    }
+    if (mark.limited) {
+        double now;
+        memMax("mem.maxVSize", now, mark.maxVSize);
+        memMax("mem.maxNSize", now, mark.maxNSize);
+    }
+    EvalMemory mem;
+    double cells[4];
+    if (gcCells(mem_peak_call_m, cells)) {
+        mem.ncells = std::max(0.0, cells[2] - mark.ncells);
+        mem.vcells = std::max(0.0, cells[3] - mark.vcells);
+        mem.bytes = mem.ncells * ConsCellBytes + mem.vcells * sizeof(double);
+    }
+    // the allocation that failed never happened, so the peak tells little;
+    // R's message does
+    if (failed && mark.budget) {
+        const char* msg = R_curErrorBuf();
+        mem.budgetExceeded = msg && (strstr(msg, "memory") || strstr(msg, "cannot allocate"));
+    }
+    last_memory_m = mem;
+    RInsideMutexLock lock(stats_mutex_m);
+    eval_stats_m.allocBytes.add(mem.bytes);
+    if (mem.budgetExceeded) eval_stats_m.overBudget++;
+}
+
 void RInside::parseEvalQ(const std::string & line) {
     SEXP ans;
     int rc = parseEval(line, ans);
     if (rc != 0) {
-        throw std::runtime_error(std::string("Error evaluating: ") + line);
+        throw std::runtime_error(errorMessage(line));
     }
 }
 
@@ -377,24 +840,506 @@ void RInside::parseEvalQNT(const std::string & line) {
 }
 
 RInside::Proxy RInside::parseEval(const std::string & line) {
+    ensureRcpp();                       // for the conversions done by the Proxy
     SEXP ans;
     int rc = parseEval(line, ans);
     if (rc != 0) {
-        throw std::runtime_error(std::string("Error evaluating: ") + line);
+        throw std::runtime_error(errorMessage(line));
     }
     return Proxy( ans );
 }
 
 RInside::Proxy RInside::parseEvalNT(const std::string & line) {
+    ensureRcpp();
     SEXP ans;
     parseEval(line, ans);
     return Proxy( ans );
 }
 
+// reached through .Call() from the handlers set up below
+SEXP RInside_Condition(SEXP type, SEXP classes, SEXP message, SEXP call) {
+    RInside* R = RInside::instancePtr();
+    if (R == NULL || R->condition_sink_m == NULL) {
+        return R_NilValue;
+    }
+    RCondition cond;
+    cond.type = (RCondition::Type) Rf_asInteger(type);
+    for (int i = 0; i < Rf_length(classes); i++) {
+        cond.classes.push_back(CHAR(STRING_ELT(classes, i)));
+    }
+    cond.message = CHAR(Rf_asChar(message));
+    cond.call = CHAR(Rf_asChar(call));
+    try {
+        R->condition_sink_m->condition(cond);
+    } catch (...) {
+        // nowhere to go from here
+    }
+    return R_NilValue;
+}
+
+void RInside::setConditionSink(ConditionSink* sink) {
+    if (sink && condition_wrapper_m == NULL) {
+        // .Call() accepts an external pointer tagged as a native symbol, so
+        // no shared library or routine registration is needed
+        SEXP env = PROTECT(Rf_NewEnvironment(R_NilValue, R_NilValue, R_BaseEnv));
+        SEXP fn = PROTECT(R_MakeExternalPtrFn((DL_FUNC) RInside_Condition, Rf_install("native symbol"), R_NilValue));
+        Rf_defineVar(Rf_install(".condition"), fn, env);
+        SEXP ans;
+        if (parseEvalEnv(".forward <- function(type, c) {"
+                         "  call <- conditionCall(c);"
+                         "  .Call(.condition, type, class(c), conditionMessage(c),"
+                         "        if (is.null(call)) '' else paste(deparse(call), collapse = ' '))"
+                         "}", ans, env, 0, false) != 0 ||
+            parseEvalEnv("function(expr) withCallingHandlers(expr,"
+                         "  message = function(c) { .forward(0L, c); invokeRestart('muffleMessage') },"
+                         "  warning = function(c) { .forward(1L, c); invokeRestart('muffleWarning') },"
+                         "  error = function(c) .forward(2L, c))", ans, env, 0, false) != 0) {
+            UNPROTECT(2);
+            throw std::runtime_error("Could not set up the condition handlers");
+        }
+        R_PreserveObject(ans);
+        condition_wrapper_m = ans;
+        UNPROTECT(2);
+    }
+    condition_sink_m = sink;
+}
+
+namespace {
+    class StringSink : public ConsoleSink {
+    public:
+        explicit StringSink(std::string& str) : str_m(str) {}
+        virtual void write(const char* data, size_t len, int oType) { str_m.append(data, len); }
+    private:
+        std::string& str_m;
+    };
+}
+
+int RInside::parseEvalCapture(const std::string & line, SEXP & ans, ConsoleSink & sink, bool messages) {
+#ifdef WIN32
+    throw std::runtime_error("Capturing output needs console hooks not available on Windows");
+#endif
+    routeConsole();
+    ConsoleSink* prev = capture_m;
+    bool prev_messages = capture_messages_m;
+    capture_m = &sink;
+    capture_messages_m = messages;
+    int rc = parseEval(line, ans);
+    capture_m = prev;
+    capture_messages_m = prev_messages;
+    return rc;
+}
+
+int RInside::parseEvalCapture(const std::string & line, SEXP & ans, std::string & output, bool messages) {
+    StringSink sink(output);
+    return parseEvalCapture(line, ans, sink, messages);
+}
+
+std::string RInside::parseEvalCapture(const std::string & line, bool messages) {
+    SEXP ans;
+    std::string output;
+    if (parseEvalCapture(line, ans, output, messages) != 0) {
+        throw std::runtime_error(errorMessage(line));
+    }
+    return output;
+}
+
+// remember what reset() goes back to; evaluated in a private environment
+// which neither user code nor reset() itself can clear
+void RInside::init_baseline() {
+    baseline_m = Rf_NewEnvironment(R_NilValue, R_NilValue, R_BaseEnv);
+    R_PreserveObject(baseline_m);
+    SEXP ans;
+    if (parseEvalEnv(".search <- search(); .options <- options(); .rng <- RNGkind();"
+                     ".argv <- get('argv', envir = .GlobalEnv)", ans, baseline_m, 0, false) != 0) {
+        throw std::runtime_error("Could not record the baseline state for reset()");
+    }
+}
+
+// R cannot be initialized twice in one process, but we can get close: user
+// bindings, attached packages, options, RNG, graphics devices and
+// connections return to what they were after construction.  Namespaces
+// loaded since stay loaded (unloading is not reliably possible), and
+// neither the autoloads nor the Rcpp state are touched.
+void RInside::reset() {
+    mb_m.rewind();                      // drop any incomplete expression
+    releaseSnapshots();
+    dropSessions();
+    SEXP ans;
+    int rc = parseEvalEnv(
+        "local({"
+        "  rm(list = ls(envir = .GlobalEnv, all.names = TRUE), envir = .GlobalEnv);"
+        "  for (p in setdiff(search(), .search)) try(detach(p, character.only = TRUE), silent = TRUE);"
+        "  added <- setdiff(names(options()), names(.options));"
+        "  if (length(added)) options(structure(vector('list', length(added)), names = added));"
+        "  try(options(.options), silent = TRUE);"
+        "  do.call(RNGkind, as.list(.rng));"
+        "  if ('grDevices' %in% loadedNamespaces()) grDevices::graphics.off();"
+        "  closeAllConnections();"
+        "  assign('argv', .argv, envir = .GlobalEnv)"
+        "})", ans, baseline_m, 0, false);
+    R_gc();
+    if (rc != 0) {
+        throw std::runtime_error("Error resetting the R session");
+    }
+}
+
+RInside::Session& RInside::session(const std::string& name) {
+    std::map<std::string, Session*>::iterator it = sessions_m.find(name);
+    Session* s;
+    if (it == sessions_m.end()) {
+        s = new Session(*this, name);
+        sessions_m[name] = s;
+    } else {
+        s = it->second;
+    }
+    s->last_use_m = ++session_clock_m;
+    return *s;
+}
+
+bool RInside::hasSession(const std::string& name) const {
+    return sessions_m.find(name) != sessions_m.end();
+}
+
+void RInside::dropSession(const std::string& name) {
+    std::map<std::string, Session*>::iterator it = sessions_m.find(name);
+    if (it != sessions_m.end()) {
+        if (it->second->busy_m) {
+            throw std::runtime_error(std::string("Session '") + name + std::string("' is evaluating"));
+        }
+        delete it->second;
+        sessions_m.erase(it);
+    }
+}
+
+void RInside::dropSessions() {
+    std::map<std::string, Session*>::iterator it;
+    for (it = sessions_m.begin(); it != sessions_m.end(); ++it) {
+        delete it->second;
+    }
+    sessions_m.clear();
+}
+
+size_t RInside::sessionBytes() {
+    size_t total = 0;
+    std::map<std::string, Session*>::iterator it;
+    for (it = sessions_m.begin(); it != sessions_m.end(); ++it) {
+        total += it->second->bytes();
+    }
+    return total;
+}
+
+void RInside::setSessionLimit(size_t bytes) {
+    session_limit_m = bytes;
+    evictSessions(NULL);
+}
+
+// evict least recently used sessions until the total fits; 'keep' (the one
+// just used) and sessions with an evaluation in progress always stay
+void RInside::evictSessions(const Session* keep) {
+    if (session_limit_m == 0) {
+        return;
+    }
+    size_t total = sessionBytes();
+    while (total > session_limit_m) {
+        std::map<std::string, Session*>::iterator it, victim = sessions_m.end();
+        for (it = sessions_m.begin(); it != sessions_m.end(); ++it) {
+            const Session* s = it->second;
+            if (s == keep || s->busy_m > 0) continue;
+            if (victim == sessions_m.end() || s->last_use_m < victim->second->last_use_m) {
+                victim = it;
+            }
+        }
+        if (victim == sessions_m.end()) {
+            break;                      // nothing left that may go
+        }
+        if (verbose_m) Rf_warning("%s: Evicting session '%s' (%lu bytes)\n", programName,
+                                  victim->first.c_str(), (unsigned long)victim->second->bytes_m);
+        total -= victim->second->bytes_m;
+        delete victim->second;
+        sessions_m.erase(victim);
+    }
+}
+
+// R_gc() always does a full collection; gc(full = FALSE) at R level is the
+// only way to ask for a cheaper one, and older R versions lack the argument
+void RInside::gc(bool full) {
+    if (!full) {
+        SEXP call = PROTECT(Rf_lang2(Rf_install("gc"), Rf_ScalarLogical(FALSE)));
+        SET_TAG(CDR(call), Rf_install("full"));
+        int errorOccurred;
+        R_tryEvalSilent(call, R_BaseEnv, &errorOccurred);
+        UNPROTECT(1);
+        if (!errorOccurred) return;
+    }
+    R_gc();
+}
+
+EvalStats RInside::evalStats() {
+    RInsideMutexLock lock(stats_mutex_m);
+    return eval_stats_m;
+}
+
+GcStats RInside::gcStats() {
+    RInsideMutexLock lock(stats_mutex_m);
+    return gc_stats_m;
+}
+
+void RInside::resetStats() {
+    RInsideMutexLock lock(stats_mutex_m);
+    eval_stats_m = EvalStats();
+    gc_stats_m = GcStats();
+}
+
+// R reports each collection when gcinfo(TRUE) but gives no pause times, and
+// while the collector runs nothing may be allocated from R.  So reports are
+// parsed from the console as they are written, and a probe, an unreferenced
+// object with a C finalizer, is collected by the very next collection of any
+// level.  Its finalizer runs once R is safe again and attributes the growth
+// of gc.time() since the previous probe to the collections reported since.
+void RInside::setGcTelemetry(bool on) {
+#ifdef WIN32
+    if (on) throw std::runtime_error("GC telemetry needs console hooks not available on Windows");
+#else
+    if (on == gc_telemetry_m) return;
+    int errorOccurred;
+    SEXP call = PROTECT(Rf_lang2(Rf_install("gcinfo"), Rf_ScalarLogical(on ? TRUE : FALSE)));
+    if (on) {
+        routeConsole();
+        if (gc_time_call_m == NULL) {
+            gc_time_call_m = Rf_lang1(Rf_install("gc.time")); // also turns on the timing
+            R_PreserveObject(gc_time_call_m);
+        }
+        SEXP t = R_tryEvalSilent(gc_time_call_m, R_BaseEnv, &errorOccurred);
+        gc_elapsed_m = (!errorOccurred && Rf_length(t) >= 3) ? REAL(t)[2] : 0.0;
+        SEXP prev = R_tryEvalSilent(call, R_BaseEnv, &errorOccurred);
+        gc_info_prev_m = !errorOccurred && Rf_asLogical(prev) == TRUE;
+        gc_report_m.clear();
+        gc_pending_m.clear();
+        {
+            RInsideMutexLock lock(stats_mutex_m);  // collectMetrics() reads it from other threads
+            gc_telemetry_m = true;
+        }
+        gcArmProbe();
+    } else {
+        {
+            RInsideMutexLock lock(stats_mutex_m);
+            gc_telemetry_m = false;     // the armed probe finds this and stops
+        }
+        SETCADR(call, Rf_ScalarLogical(gc_info_prev_m));
+        R_tryEvalSilent(call, R_BaseEnv, &errorOccurred);
+    }
+    UNPROTECT(1);
+#endif
+}
+
+void RInside_GcProbe(SEXP probe) {
+    RInside* R = RInside::instancePtr();
+    if (R) R->gcProbe();
+}
+
+void RInside::gcArmProbe() {
+    SEXP probe = PROTECT(R_MakeExternalPtr(NULL, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(probe, RInside_GcProbe, FALSE);
+    UNPROTECT(1);                       // garbage from here on
+}
+
+void RInside::gcProbe() {
+    if (!gc_telemetry_m) return;
+    int errorOccurred;
+    SEXP t = R_tryEvalSilent(gc_time_call_m, R_BaseEnv, &errorOccurred);
+    double elapsed = (!errorOccurred && Rf_length(t) >= 3) ? REAL(t)[2] : gc_elapsed_m;
+    double pause = (elapsed - gc_elapsed_m) * 1.0e6;
+    gc_elapsed_m = elapsed;
+    {
+        RInsideMutexLock lock(stats_mutex_m);
+        GcStats& st = gc_stats_m;
+        if (gc_pending_m.empty()) {     // gcinfo() turned off behind our back
+            st.collections++;
+            st.pauseUsec.add(pause);
+        }
+        for (size_t i = 0; i < gc_pending_m.size(); i++) {
+            const GcEvent& ev = gc_pending_m[i];
+            double each = pause / gc_pending_m.size();
+            st.collections++;
+            st.byLevel[ev.level]++;
+            st.pauseUsec.add(each);
+            st.pauseUsecByLevel[ev.level].add(each);
+            if (st.consHeapBytes > ev.consBytes) st.reclaimedBytesMax += st.consHeapBytes - ev.consBytes;
+            if (st.vectorHeapBytes > ev.vectorBytes) st.reclaimedBytesMax += st.vectorHeapBytes - ev.vectorBytes;
+            st.consBytes = ev.consBytes;
+            st.vectorBytes = ev.vectorBytes;
+            st.consHeapBytes = ev.consHeapBytes;
+            st.vectorHeapBytes = ev.vectorHeapBytes;
+        }
+    }
+    gc_pending_m.clear();
+    gcArmProbe();
+}
+
+// called with R's collector running: take the report apart without
+// allocating anything from R.  It arrives in pieces, as
+//   Garbage collection 12 = 8+2+2 (level 0) ...
+//   6.5 Mbytes of cons cells used (45%)
+//   1.2 Mbytes of vectors used (30%)
+bool RInside::gcReport(const char* buf, int len) {
+    static const char start[] = "Garbage collection ";
+    if (gc_report_m.empty()) {
+        if (len < (int)sizeof(start) - 1 || strncmp(buf, start, sizeof(start) - 1) != 0) {
+            return false;
+        }
+    }
+    gc_report_m.append(buf, len);
+    if (gc_report_m.find("of vectors used") == std::string::npos ||
+        gc_report_m[gc_report_m.size() - 1] != '\n') {
+        return true;                    // more to come
+    }
+    const double Mega = 1048576.0;
+    GcEvent ev;
+    ev.level = GcStats::Levels - 1;
+    ev.consBytes = ev.consHeapBytes = ev.vectorBytes = ev.vectorHeapBytes = 0.0;
+    std::string::size_type pos = gc_report_m.find("(level ");
+    if (pos != std::string::npos) {
+        ev.level = atoi(gc_report_m.c_str() + pos + 7);
+        if (ev.level < 0 || ev.level >= GcStats::Levels) ev.level = GcStats::Levels - 1;
+    }
+    for (pos = 0; pos != std::string::npos; pos = gc_report_m.find('\n', pos + 1)) {
+        const char* line = gc_report_m.c_str() + pos + (pos ? 1 : 0);
+        double mb;
+        int pct;
+        if (sscanf(line, "%lf Mbytes of cons cells used (%d%%)", &mb, &pct) == 2) {
+            ev.consBytes = mb * Mega;
+            ev.consHeapBytes = pct > 0 ? ev.consBytes * 100.0 / pct : 0.0;
+        } else if (sscanf(line, "%lf Mbytes of vectors used (%d%%)", &mb, &pct) == 2) {
+            ev.vectorBytes = mb * Mega;
+            ev.vectorHeapBytes = pct > 0 ? ev.vectorBytes * 100.0 / pct : 0.0;
+        }
+    }
+    gc_pending_m.push_back(ev);
+    gc_report_m.clear();
+    return true;
+}
+
+#ifndef WIN32
+void RInside_ConsoleRouter(const char* buf, int len, int otype) {
+    RInside::instance().consoleWrite(buf, len, otype);
+}
+#endif
+
+// Send R's console output, stdout and stderr alike, through consoleWrite()
+// which passes it on to the callbacks if set, else to where it went before
+void RInside::routeConsole() {
+#ifndef WIN32
+    if (console_routed_m) return;
+    console_out_m = R_Outputfile;
+    console_err_m = R_Consolefile;
+    console_prev_m = ptr_R_WriteConsoleEx;
+    console_prev_plain_m = ptr_R_WriteConsole;
+    ptr_R_WriteConsoleEx = RInside_ConsoleRouter;
+    ptr_R_WriteConsole = NULL;
+    R_Outputfile = NULL;
+    R_Consolefile = NULL;
+    console_routed_m = true;
+#endif
+}
+
+void RInside::consoleWrite(const char* buf, int len, int otype) {
+    if (gc_telemetry_m && otype != 0 && gcReport(buf, len)) {
+        return;
+    }
+    countConsole(len, otype);
+    if (capture_m && (otype == 0 || capture_messages_m)) {
+        capture_m->write(buf, len, otype);
+        return;
+    }
+#ifdef RINSIDE_CALLBACKS
+    if (callbacks && callbacks->writesConsole()) {
+        callbacks->WriteConsole_(buf, len, otype);
+        return;
+    }
+#endif
+    FILE* fp = otype ? console_err_m : console_out_m;
+    if (fp) {
+        fwrite(buf, sizeof(char), len, fp);
+    } else if (console_prev_m) {
+        console_prev_m(buf, len, otype);
+    } else if (console_prev_plain_m) {
+        console_prev_plain_m(buf, len);
+    }
+}
+
+// the thresholds move only through R_SetParams(), which also sets all the
+// other fields: those which may have changed since initialize() are taken
+// from R as it is now, the stack and connection sizes cannot change
+void RInside::setGcTriggers(size_t vcells, size_t ncells) {
+    structRstart Rst = params_m;
+    structRstart def;
+    R_DefParams(&def);
+    double max;
+    if (memMax("mem.maxVSize", max)) {
+        Rst.max_vsize = R_FINITE(max) ? (size_t) (max * 1048576.0) : def.max_vsize;
+    }
+    if (memMax("mem.maxNSize", max)) {
+        Rst.max_nsize = R_FINITE(max) ? (size_t) max : def.max_nsize;
+    }
+    Rst.R_Interactive = R_Interactive;
+    Rst.vsize = vcells;
+    Rst.nsize = ncells;
+    R_SetParams(&Rst);
+    params_m.vsize = vcells;
+    params_m.nsize = ncells;
+}
+
+RInside::GcScope::GcScope(RInside& R, size_t vsize, size_t nsize)
+    : R_m(R), vcells_m(R.params_m.vsize), ncells_m(R.params_m.nsize) {
+    size_t vcells = vsize / sizeof(double);
+    R_m.setGcTriggers(vcells > vcells_m ? vcells : vcells_m, nsize > ncells_m ? nsize : ncells_m);
+}
+
+RInside::GcScope::~GcScope() {
+    R_m.setGcTriggers(vcells_m, ncells_m);
+}
+
 Rcpp::Environment::Binding RInside::operator[]( const std::string& name ){
+    ensureRcpp();
     return (*global_env_m)[name];
 }
 
+RInsideSnapshot RInside::snapshot(const std::string& name) {
+    SEXP x = Rf_findVarInFrame(R_GlobalEnv, Rf_install(name.c_str()));
+    if (x == R_UnboundValue) {
+        throw std::runtime_error(std::string("No object '") + name + std::string("' in global environment"));
+    }
+    if (TYPEOF(x) == PROMSXP) {
+        x = Rf_eval(x, R_GlobalEnv);
+    }
+    return RInsideSnapshot(x);
+}
+
+RInsideSnapshot RInside::snapshot(SEXP x) {
+    return RInsideSnapshot(x);
+}
+
+// called from ~RInsideSnapshot on whichever thread dropped the last reference
+void RInside::releaseSnapshot(SEXP x) {
+    if (pthread_equal(pthread_self(), r_thread_m)) {
+        R_ReleaseObject(x);
+    } else {
+        RInsideMutexLock lock(released_mutex_m);
+        released_m.push_back(x);
+    }
+}
+
+void RInside::releaseSnapshots() {
+    std::vector<SEXP> pending;
+    {
+        RInsideMutexLock lock(released_mutex_m);
+        pending.swap(released_m);
+    }
+    for (size_t i = 0; i < pending.size(); i++) {
+        R_ReleaseObject(pending[i]);
+    }
+}
+
 RInside& RInside::instance(){
     return *instance_m;
 }
@@ -413,6 +1358,9 @@ void Callbacks::Busy_( int which ){
 }
 
 int Callbacks::ReadConsole_( const char* prompt, unsigned char* buf, int len, int addtohistory ){
+    if( input_source ){
+        return ReadInput_( buf, len ) ;
+    }
     try {
         std::string res( ReadConsole( prompt, static_cast<bool>(addtohistory) ) ) ;
 
@@ -430,18 +1378,117 @@ int Callbacks::ReadConsole_( const char* prompt, unsigned char* buf, int len, in
 }
 
 
+void Callbacks::setInputSource( InputSource* source ){
+    input_source = source ;
+    input_pos = input_end = input_nl = 0 ;
+    input_eof = false ;
+}
+
+// Read from the source until a complete line or room bytes are waiting, or
+// only as long as that does not block when wait is false
+void Callbacks::fillInput_( bool wait ){
+    while( !input_eof && input_nl <= input_pos && input_end - input_pos < input_room ){
+        if( input_pos > 0 ){            // keep the unconsumed rest at the front
+            memmove( &input_buf[0], &input_buf[input_pos], input_end - input_pos ) ;
+            input_end -= input_pos ;
+            input_nl = 0 ;
+            input_pos = 0 ;
+        }
+        if( !wait && !input_source->ready() ){
+            break ;
+        }
+        size_t chunk = (input_room > 65536) ? input_room : 65536 ;
+        if( input_buf.size() < input_end + chunk ){
+            input_buf.resize( input_end + chunk ) ;
+        }
+        size_t n = input_source->read( &input_buf[input_end], input_buf.size() - input_end ) ;
+        if( n == 0 ){
+            input_eof = true ;
+        }
+        for( size_t i = input_end + n ; i > input_end ; i-- ){
+            if( input_buf[i - 1] == '\n' ){
+                input_nl = i ;
+                break ;
+            }
+        }
+        input_end += n ;
+    }
+}
+
+// R takes its input a buffer of len bytes at a time, NUL terminated: give
+// it as many whole lines as fit, or a piece of a line longer than the buffer
+// which R then continues with on the next call.  A shorter line is only
+// given once it is complete, and the last one gets its newline at the end
+// of the source as with std_ReadConsole(), so R never parses half a line.
+// The source is only read from when no complete line is waiting, so
+// interactive sources do not block early.
+int Callbacks::ReadInput_( unsigned char* buf, int len ){
+    size_t room = (len > 2) ? len - 2 : 0 ;     // leaves space for a newline
+    input_room = room ;
+    fillInput_( true ) ;
+    size_t avail = input_end - input_pos ;
+    if( avail == 0 ){
+        return 0 ;                      // end of input
+    }
+    size_t n = (avail < room) ? avail : room ;
+    size_t nl = n ;                     // end on a line boundary if there is one
+    while( nl > 0 && input_buf[input_pos + nl - 1] != '\n' ) nl-- ;
+    if( nl > 0 ) n = nl ;
+    memcpy( buf, &input_buf[input_pos], n ) ;
+    input_pos += n ;
+    if( nl == 0 && n < room ){          // the unterminated last line
+        buf[n++] = '\n' ;
+    }
+    buf[n] = 0 ;
+    return 1 ;
+}
+
+bool Callbacks::inputReady(){
+    if( !input_source ) return true ;   // ReadConsole() has to answer, whatever it takes
+    fillInput_( false ) ;               // a partial line is held back until it is complete
+    return input_eof || input_nl > input_pos || input_end - input_pos >= input_room ;
+}
+
+void Callbacks::ProcessEvents_(){
+    if (in_events) return ;             // host event handlers may call back into R
+    struct timeval now ;
+    gettimeofday(&now, NULL) ;
+    long elapsed = (now.tv_sec - last_poll.tv_sec) * 1000000L + (now.tv_usec - last_poll.tv_usec) ;
+    if (elapsed >= 0 && elapsed < poll_usec) return ;
+    in_events = true ;
+    try {
+        ProcessEvents() ;
+    } catch( const std::exception& ex){
+        // nothing sensible to do with it while R is evaluating
+    } catch( ... ){
+        // nor with anything else thrown, which must not unwind R's frames
+    }
+    in_events = false ;
+    gettimeofday(&last_poll, NULL) ;    // measure the interval from the end of the last pump
+}
+
 void Callbacks::WriteConsole_( const char* buf, int len, int oType ){
-    if( len ){
+    if( console_sink ){
+        console_sink->write( buf, len, oType ) ;
+    } else if( len ){
         buffer.assign( buf, len ) ;
         WriteConsole( buffer, oType) ;
     }
 }
 
+void Callbacks::FlushConsole_(){
+    if( console_sink ){
+        console_sink->flush() ;
+    }
+    FlushConsole() ;
+}
+
 void RInside_ShowMessage( const char* message ){
     RInside::instance().callbacks->ShowMessage( message ) ;
 }
 
 void RInside_WriteConsoleEx( const char* message, int len, int oType ){
+    RInside::instance().countConsole(len, oType);
     RInside::instance().callbacks->WriteConsole_( message, len, oType ) ;
 }
 
@@ -454,7 +1501,7 @@ void RInside_ResetConsole(){
 }
 
 void RInside_FlushConsole(){
-    RInside::instance().callbacks->FlushConsole() ;
+    RInside::instance().callbacks->FlushConsole_() ;
 }
 
 void RInside_ClearerrConsole(){
@@ -465,6 +1512,21 @@ void RInside_Busy( int which ){
     RInside::instance().callbacks->Busy_(which) ;
 }
 
+#ifndef WIN32
+static void (*RInside_PrevPolledEvents)(void) = NULL ;
+#endif
+
+void RInside_ProcessEvents(){
+    RInside::instance().callbacks->ProcessEvents_() ;
+}
+
+#ifndef WIN32
+static void RInside_PolledEvents(){
+    RInside_ProcessEvents() ;
+    if (RInside_PrevPolledEvents) RInside_PrevPolledEvents() ;
+}
+#endif
+
 void RInside::set_callbacks(Callbacks* callbacks_){
     callbacks = callbacks_ ;
 
@@ -476,17 +1538,18 @@ void RInside::set_callbacks(Callbacks* callbacks_){
     if( callbacks->has_ShowMessage() ){
         ptr_R_ShowMessage = RInside_ShowMessage ;
     }
-    if( callbacks->has_ReadConsole() ){
+    if( callbacks->readsConsole() ){
         ptr_R_ReadConsole = RInside_ReadConsole;
     }
-    if( callbacks->has_WriteConsole() ){
-        ptr_R_WriteConsoleEx = RInside_WriteConsoleEx ;
+    if( callbacks->writesConsole() ){
+        // when routed, the router hands output on to the callbacks itself
+        ptr_R_WriteConsoleEx = console_routed_m ? RInside_ConsoleRouter : RInside_WriteConsoleEx ;
         ptr_R_WriteConsole = NULL;
         }
     if( callbacks->has_ResetConsole() ){
         ptr_R_ResetConsole = RInside_ResetConsole;
     }
-    if( callbacks->has_FlushConsole() ){
+    if( callbacks->has_FlushConsole() || callbacks->getConsoleSink() ){
         ptr_R_FlushConsole = RInside_FlushConsole;
     }
     if( callbacks->has_CleanerrConsole() ){
@@ -495,6 +1558,17 @@ void RInside::set_callbacks(Callbacks* callbacks_){
     if( callbacks->has_Busy() ){
         ptr_R_Busy = RInside_Busy;
     }
+    if( callbacks->has_ProcessEvents() ){
+        // R_ProcessEvents() is reached from R_CheckUserInterrupt() during long
+        // evaluations, R_PolledEvents() also while R waits (eg in Sys.sleep)
+        if (R_PolledEvents != RInside_PolledEvents) {
+            RInside_PrevPolledEvents = R_PolledEvents ;
+        }
+        ptr_R_ProcessEvents = RInside_ProcessEvents ;
+        R_PolledEvents = RInside_PolledEvents ;
+        int wait_usec = callbacks->getPollingInterval() * 1000 ;
+        R_wait_usec = (wait_usec > 0) ? wait_usec : 1000 ;
+    }
 
     R_Outputfile = NULL;
     R_Consolefile = NULL;
@@ -506,4 +1580,109 @@ void RInside::repl(){
     while( R_ReplDLLdo1() > 0 ) {}
 }
 
+// R_ReplDLLdo1() would long jump to the frame of an R_ReplDLLinit() long
+// returned from on any error, and empties the protection stack, so a step
+// parses and evaluates with R_tryEval() instead, each top-level expression
+// in a context of its own, and prints visible values as R's REPL does
+int RInside::replEval(const std::string& text, bool last){
+    ParseStatus status;
+    SEXP cmd = PROTECT(Rf_mkString(text.c_str()));
+    SEXP exprs = PROTECT(R_ParseVector(cmd, -1, &status, R_NilValue));
+    if( status == PARSE_INCOMPLETE && !last ){
+        UNPROTECT(2);
+        return -1;
+    }
+    if( status != PARSE_OK && status != PARSE_ERROR && status != PARSE_INCOMPLETE ){
+        UNPROTECT(2);                   // nothing but blanks and comments
+        return 0;
+    }
+    EvalStart start;
+    evalBegin(start);
+    int errorOccurred, n = 0;
+    if( status != PARSE_OK ){           // parse() again, for R's own message
+        SEXP parse = PROTECT(Rf_lang2(Rf_install("parse"), cmd));
+        SET_TAG(CDR(parse), Rf_install("text"));
+        R_tryEval(parse, R_BaseEnv, &errorOccurred);
+        UNPROTECT(3);
+        evalDone(start, 1);
+        return 1;
+    }
+    releaseSnapshots();
+    SEXP withVisible = Rf_install("withVisible");
+    int rc = 0;
+    for( n = 0; n < Rf_length(exprs) && rc == 0; n++ ){
+        if( n > 0 && queue_m ){         // as between the expressions of parseEval()
+            queue_m->yieldPoint();
+        }
+        SEXP call = PROTECT(Rf_lang2(withVisible, VECTOR_ELT(exprs, n)));
+        if( condition_sink_m ){
+            call = Rf_lang2(condition_wrapper_m, call);
+            UNPROTECT(1);
+            PROTECT(call);
+        }
+        SEXP res = PROTECT(R_tryEval(call, R_GlobalEnv, &errorOccurred));
+        if( errorOccurred ){            // R_tryEval() has shown the error
+            rc = 1;
+        } else if( Rf_asLogical(VECTOR_ELT(res, 1)) == TRUE ){
+            SEXP quoted = PROTECT(Rf_lang2(Rf_install("quote"), VECTOR_ELT(res, 0)));
+            SEXP print = PROTECT(Rf_lang2(Rf_install("print"), quoted));
+            R_tryEval(print, R_GlobalEnv, &errorOccurred);
+            UNPROTECT(2);
+        }
+        UNPROTECT(2);
+    }
+    evalDone(start, rc);
+    UNPROTECT(2);
+    return n;
+}
+
+// Lines are taken from the callbacks one at a time, so that expressions
+// can be counted, and only asked for when inputReady() says they are
+// there, so R is never let in to block on a read
+RInside::ReplStatus RInside::replStep(int maxExpressions, long maxUsec){
+    if( !callbacks || !callbacks->readsConsole() ){
+        throw std::runtime_error("replStep() needs callbacks to read input from");
+    }
+    double start = monotonicUsec();
+    int done = 0;
+    for(;;){
+        if( repl_input_m.empty() ){
+            if( !callbacks->inputReady() ){
+                return ReplNeedInput;
+            }
+            unsigned char buf[4096];
+            const char* prompt = repl_expr_m.empty() ? "> " : "+ ";
+            if( callbacks->ReadConsole_( prompt, buf, sizeof(buf), 1 ) <= 0 ){
+                if( !repl_expr_m.empty() ){     // for R's "unexpected end of input"
+                    replEval( repl_expr_m, true ) ;
+                    repl_expr_m.clear();
+                }
+                return ReplEnd;
+            }
+            repl_input_m = reinterpret_cast<char*>(buf);
+            if( !callbacks->getInputSource() &&
+                (repl_input_m.empty() || repl_input_m[repl_input_m.size() - 1] != '\n') ){
+                repl_input_m += '\n';  // ReadConsole() answers with a line
+            }
+        }
+        size_t nl = repl_input_m.find('\n');
+        size_t len = (nl == std::string::npos) ? repl_input_m.size() : nl + 1;
+        repl_expr_m.append(repl_input_m, 0, len);
+        repl_input_m.erase(0, len);
+        if( nl == std::string::npos ){  // a piece of a line longer than R's buffer
+            continue;
+        }
+        int n = replEval(repl_expr_m);
+        if( n < 0 ){                    // in the middle of an expression
+            continue;
+        }
+        repl_expr_m.clear();
+        done += n;
+        if( (maxExpressions > 0 && done >= maxExpressions) ||
+            (maxUsec > 0 && monotonicUsec() - start >= maxUsec) ){
+            return ReplYield;
+        }
+    }
+}
+
 #endif
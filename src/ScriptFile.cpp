@@ -0,0 +1,218 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// ScriptFile.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <RInside.h>
+#include <Timing.h>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    // Hands out the lines of a file, newline included.  The file is mapped
+    // where possible, and pages already read are dropped again so that the
+    // resident size does not grow with the script.
+    class ScriptLines {
+    public:
+        explicit ScriptLines(const std::string& path) : base(NULL), size(0), pos(0), dropped(0), fd(-1), fp(NULL) {
+#ifndef WIN32
+            struct stat st;
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd >= 0 && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+                size = (size_t) st.st_size;
+                if (size == 0) return;
+                void* p = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    base = static_cast<const char*>(p);
+                    ::madvise(p, size, MADV_SEQUENTIAL);
+                    return;
+                }
+            }
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+#endif
+            size = 0;
+            fp = ::fopen(path.c_str(), "rb");
+            if (fp == NULL) {
+                throw std::runtime_error(std::string("Could not open R script ") + path);
+            }
+        }
+        ~ScriptLines() {
+#ifndef WIN32
+            if (base) ::munmap(const_cast<char*>(base), size);
+            if (fd >= 0) ::close(fd);
+#endif
+            if (fp) ::fclose(fp);
+        }
+
+        // appends the next line to 'text', false at the end of the file
+        bool next(std::string& text) {
+            if (fp) {
+                char buf[4096];
+                bool any = false;
+                while (::fgets(buf, sizeof(buf), fp)) {
+                    size_t n = strlen(buf);
+                    text.append(buf, n);
+                    any = true;
+                    if (buf[n - 1] == '\n') break;
+                }
+                return any;
+            }
+            if (pos >= size) {
+                return false;
+            }
+            const char* nl = static_cast<const char*>(memchr(base + pos, '\n', size - pos));
+            size_t end = nl ? (size_t) (nl - base) + 1 : size;
+            text.append(base + pos, end - pos);
+            pos = end;
+#ifndef WIN32
+            if (pos - dropped >= DropBytes) {
+                size_t page = (size_t) ::sysconf(_SC_PAGESIZE);
+                size_t upto = pos / page * page;
+                ::madvise(const_cast<char*>(base) + dropped, upto - dropped, MADV_DONTNEED);
+                dropped = upto;
+            }
+#endif
+            return true;
+        }
+
+    private:
+        enum { DropBytes = 8 * 1024 * 1024 };
+        const char* base;
+        size_t size, pos, dropped;
+        int fd;
+        FILE* fp;
+
+        ScriptLines(const ScriptLines&);
+        ScriptLines& operator=(const ScriptLines&);
+    };
+
+    bool blank(const std::string& text) {
+        return text.find_first_not_of(" \t\r\n\f") == std::string::npos;
+    }
+
+    std::string location(const std::string& path, int line, const char* what) {
+        std::ostringstream os;
+        os << path << ":" << line << ": " << what;
+        return os.str();
+    }
+}
+
+// Lines are collected until they parse as complete statements, which are
+// then evaluated and let go, so only the statement at hand is ever held.
+// A statement is normally tried after each line; once it grows large the
+// attempts are spaced out by size so that a long literal is not reparsed
+// line after line.
+int RInside::parseEvalFile(const std::string & path, bool stopOnError) {
+    const size_t EagerBytes = 64 * 1024;
+    ScriptLines lines(path);
+    std::string text;
+    size_t tried = 0;                   // size of the text at the last incomplete parse
+    int lineno = 0, first = 1, failed = 0;
+    bool more = true;
+    EvalStart start;
+    evalBegin(start);
+
+    releaseSnapshots();
+    eval_depth_m++;
+    MemoryMark mark;
+    memoryBegin(mark, eval_budget_m);
+
+    while (more) {
+        more = lines.next(text);
+        if (more) {
+            lineno++;
+            if (text.size() > EagerBytes && text.size() < 2 * tried) {
+                continue;
+            }
+        }
+        if (blank(text)) {
+            if (!more) break;
+            text.clear();
+            first = lineno + 1;
+            continue;
+        }
+
+        ParseStatus status = PARSE_ERROR;
+        const char* error = NULL;
+        if (text.find('\0') != std::string::npos) {
+            // Rf_mkCharLen() would raise an R error, with no tryEval to catch it
+            error = "Embedded nul in R code";
+        } else {
+            SEXP cmdSexp = PROTECT(Rf_allocVector(STRSXP, 1));
+            SET_STRING_ELT(cmdSexp, 0, Rf_mkCharLen(text.data(), (int) text.size()));
+            SEXP cmdexpr = PROTECT(R_ParseVector(cmdSexp, -1, &status, R_NilValue));
+
+            if (status == PARSE_INCOMPLETE && more) {
+                tried = text.size();
+                UNPROTECT(2);
+                continue;
+            } else if (status == PARSE_OK) {
+                SEXP ans;
+                if (evalExpressions(cmdexpr, R_GlobalEnv, ans) != 0) {
+                    error = "Error evaluating R code";
+                }
+            } else if (status == PARSE_INCOMPLETE) {
+                error = "Incomplete R code at end of file";
+            } else if (status != PARSE_NULL) {
+                error = "Parse error";
+            }
+            UNPROTECT(2);
+        }
+
+        if (error) {
+            failed++;
+            if (verbose_m) Rf_warning("%s:%d: %s\n", path.c_str(), first, error);
+            if (stopOnError) {
+                std::string msg = location(path, first, error);
+                if (status == PARSE_OK) {   // with R's own message
+                    std::string buf(R_curErrorBuf());
+                    msg += ": " + buf.substr(0, buf.find_last_not_of("\n") + 1);
+                }
+                memoryEnd(mark, true);
+                eval_depth_m--;
+                evalDone(start, 1);
+                throw std::runtime_error(msg);
+            }
+        }
+        text.clear();
+        tried = 0;
+        first = lineno + 1;
+    }
+
+    memoryEnd(mark, failed > 0);
+    eval_depth_m--;
+    if (temp_limit_m && eval_depth_m == 0) {
+        checkTempLimit();
+    }
+    evalDone(start, failed > 0);
+    return failed;
+}
@@ -0,0 +1,233 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Session.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <RInside.h>
+
+namespace {
+
+    // approximate sizes on 64-bit builds, close to what object.size() reports
+    const size_t NodeBytes = 56;
+    const size_t VectorHeaderBytes = 48;
+
+    size_t vectorBytes(R_xlen_t n, size_t eltsize) {
+        return VectorHeaderBytes + ((n * eltsize + 7) & ~(size_t)7);
+    }
+
+    // Like object.size(), objects referenced twice are counted twice, and
+    // environments are not followed as they are typically shared.
+    size_t objectBytes(SEXP x, int depth) {
+        if (x == R_NilValue || depth > 64) {
+            return 0;
+        }
+        size_t bytes = 0;
+        R_xlen_t i, n;
+        switch (TYPEOF(x)) {
+        case SYMSXP:
+        case ENVSXP:
+            return 0;
+        case LGLSXP:
+        case INTSXP:
+            bytes = vectorBytes(XLENGTH(x), sizeof(int));
+            break;
+        case REALSXP:
+            bytes = vectorBytes(XLENGTH(x), sizeof(double));
+            break;
+        case CPLXSXP:
+            bytes = vectorBytes(XLENGTH(x), sizeof(Rcomplex));
+            break;
+        case RAWSXP:
+            bytes = vectorBytes(XLENGTH(x), 1);
+            break;
+        case CHARSXP:
+            bytes = vectorBytes(LENGTH(x) + 1, 1);
+            break;
+        case STRSXP:
+            n = XLENGTH(x);
+            bytes = vectorBytes(n, sizeof(SEXP));
+            for (i = 0; i < n; i++) {
+                if (STRING_ELT(x, i) != NA_STRING) {
+                    bytes += objectBytes(STRING_ELT(x, i), depth + 1);
+                }
+            }
+            break;
+        case VECSXP:
+        case EXPRSXP:
+            n = XLENGTH(x);
+            bytes = vectorBytes(n, sizeof(SEXP));
+            for (i = 0; i < n; i++) {
+                bytes += objectBytes(VECTOR_ELT(x, i), depth + 1);
+            }
+            break;
+        case LISTSXP:
+        case LANGSXP:
+            bytes = objectBytes(ATTRIB(x), depth + 1);
+            for (; x != R_NilValue && (TYPEOF(x) == LISTSXP || TYPEOF(x) == LANGSXP); x = CDR(x)) {
+                bytes += NodeBytes + objectBytes(CAR(x), depth + 1);
+            }
+            return bytes;
+        case CLOSXP:
+            bytes = NodeBytes + objectBytes(FORMALS(x), depth + 1) + objectBytes(BODY(x), depth + 1);
+            break;
+        case PROMSXP:                   // unforced ones hold R_UnboundValue, a symbol
+            bytes = NodeBytes + objectBytes(PRVALUE(x), depth + 1);
+            break;
+        default:
+            bytes = NodeBytes;
+            break;
+        }
+        return bytes + objectBytes(ATTRIB(x), depth + 1);
+    }
+
+    // what tells whether a binding needs measuring again: another object,
+    // a vector grown in place, or a list with elements replaced in place
+    size_t listElements(SEXP x) {
+        size_t sum = 0;
+        if (TYPEOF(x) == VECSXP || TYPEOF(x) == EXPRSXP) {
+            for (R_xlen_t i = 0; i < XLENGTH(x); i++) {
+                sum += (size_t) VECTOR_ELT(x, i);
+            }
+        }
+        return sum;
+    }
+
+}
+
+RInside::Session::Session(RInside& R, const std::string& name)
+    : R_m(R), name_m(name), rcpp_env_m(NULL), last_use_m(0), bytes_m(0), dirty_m(false), busy_m(0), budget_m(0) {
+    env_m = Rf_NewEnvironment(R_NilValue, R_NilValue, R_GlobalEnv);
+    R_PreserveObject(env_m);
+}
+
+RInside::Session::~Session() {
+    delete rcpp_env_m;
+    R_ReleaseObject(env_m);
+}
+
+void RInside::Session::used() {
+    last_use_m = ++R_m.session_clock_m;
+}
+
+// only bindings which are new or changed are measured, the others keep
+// their size from last time
+void RInside::Session::measure() {
+    SEXP names = PROTECT(R_lsInternal(env_m, TRUE));
+    std::map<std::string, Sized> sizes;
+    bytes_m = 0;
+    for (int i = 0; i < Rf_length(names); i++) {
+        std::string name(CHAR(STRING_ELT(names, i)));
+        SEXP x = Rf_findVarInFrame(env_m, Rf_install(name.c_str()));
+        if (x == R_UnboundValue) continue;
+        Sized& now = sizes[name];
+        now.object = x;
+        now.length = Rf_isVector(x) ? XLENGTH(x) : 0;
+        now.elements = listElements(x);
+        std::map<std::string, Sized>::const_iterator it = sizes_m.find(name);
+        if (it != sizes_m.end() && it->second.object == x && it->second.length == now.length &&
+            it->second.elements == now.elements) {
+            now.bytes = it->second.bytes;
+        } else {
+            now.bytes = objectBytes(x, 0);
+        }
+        bytes_m += now.bytes;
+    }
+    UNPROTECT(1);
+    sizes_m.swap(sizes);
+    dirty_m = false;
+}
+
+size_t RInside::Session::bytes() {
+    if (dirty_m) {
+        measure();
+    }
+    return bytes_m;
+}
+
+void RInside::Session::assigned(const std::string& name, SEXP x) {
+    used();
+    if (!dirty_m) {                     // else measured as a whole when next needed
+        Sized& s = sizes_m[name];
+        if (s.object != NULL) bytes_m -= s.bytes;
+        s.object = x;
+        s.length = Rf_isVector(x) ? XLENGTH(x) : 0;
+        s.elements = listElements(x);
+        s.bytes = objectBytes(x, 0);
+        bytes_m += s.bytes;
+    }
+    R_m.evictSessions(this);
+}
+
+Rcpp::Environment& RInside::Session::rcppEnv() {
+    if (rcpp_env_m == NULL) {
+        R_m.ensureRcpp();
+        rcpp_env_m = new Rcpp::Environment(env_m);
+    }
+    return *rcpp_env_m;
+}
+
+int RInside::Session::parseEval(const std::string & line, SEXP & ans) {
+    used();
+    dirty_m = true;                     // whatever the code assigned or removed
+    ans = R_NilValue;                   // also when the expression is incomplete
+    busy_m++;
+    int rc = R_m.parseEvalEnv(line, ans, env_m, budget_m ? budget_m : R_m.eval_budget_m);
+    busy_m--;
+    if (rc == 0) {
+        PROTECT(ans);                   // measuring allocates
+        R_m.evictSessions(this);
+        UNPROTECT(1);
+    }
+    return rc;
+}
+
+void RInside::Session::parseEvalQ(const std::string & line) {
+    SEXP ans;
+    int rc = parseEval(line, ans);
+    if (rc != 0) {
+        throw std::runtime_error(R_m.errorMessage(line));
+    }
+}
+
+void RInside::Session::parseEvalQNT(const std::string & line) {
+    SEXP ans;
+    parseEval(line, ans);
+}
+
+RInside::Proxy RInside::Session::parseEval(const std::string & line) {
+    R_m.ensureRcpp();
+    SEXP ans;
+    int rc = parseEval(line, ans);
+    if (rc != 0) {
+        throw std::runtime_error(R_m.errorMessage(line));
+    }
+    return Proxy( ans );
+}
+
+RInside::Proxy RInside::Session::parseEvalNT(const std::string & line) {
+    R_m.ensureRcpp();
+    SEXP ans;
+    parseEval(line, ans);
+    return Proxy( ans );
+}
+
+RInside::Session::Binding RInside::Session::operator[]( const std::string& name ){
+    used();
+    return Binding(*this, name);
+}
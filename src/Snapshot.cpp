@@ -0,0 +1,93 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Snapshot.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <RInside.h>
+#include <Snapshot.h>
+
+RInsideSnapshot::RInsideSnapshot() : state_m(NULL) {}
+
+RInsideSnapshot::RInsideSnapshot(SEXP x) : state_m(NULL) {
+    const void* data;
+    switch (TYPEOF(x)) {
+    case REALSXP: data = REAL(x);    break;
+    case INTSXP:  data = INTEGER(x); break;
+    case LGLSXP:  data = LOGICAL(x); break;
+    case RAWSXP:  data = RAW(x);     break;
+    case CPLXSXP: data = COMPLEX(x); break;
+    default:
+        throw std::runtime_error("snapshots require an atomic vector of numeric, logical, raw or complex type");
+    }
+    // any later modification from R code now has to duplicate first,
+    // so the memory seen by readers never changes underneath them
+#ifdef MARK_NOT_MUTABLE
+    MARK_NOT_MUTABLE(x);
+#else
+    SET_NAMED(x, 2);
+#endif
+    R_PreserveObject(x);
+    state_m = new State;
+    state_m->x = x;
+    state_m->data = data;
+    state_m->size = Rf_xlength(x);
+    state_m->type = TYPEOF(x);
+    state_m->refs = 1;
+}
+
+RInsideSnapshot::RInsideSnapshot(const RInsideSnapshot& other) : state_m(other.state_m) {
+    if (state_m) __sync_add_and_fetch(&state_m->refs, 1);
+}
+
+RInsideSnapshot& RInsideSnapshot::operator=(const RInsideSnapshot& other) {
+    if (state_m != other.state_m) {
+        if (other.state_m) __sync_add_and_fetch(&other.state_m->refs, 1);
+        release();
+        state_m = other.state_m;
+    }
+    return *this;
+}
+
+RInsideSnapshot::~RInsideSnapshot() {
+    release();
+}
+
+void RInsideSnapshot::release() {
+    if (state_m && __sync_sub_and_fetch(&state_m->refs, 1) == 0) {
+        RInside* R = RInside::instancePtr();
+        if (R) {                        // else R is gone and so is the object
+            R->releaseSnapshot(state_m->x);
+        }
+        delete state_m;
+    }
+    state_m = NULL;
+}
+
+const void* RInsideSnapshot::typed(int type) const {
+    if (state_m == NULL || state_m->type != type) {
+        throw std::runtime_error("snapshot does not hold a vector of the requested type");
+    }
+    return state_m->data;
+}
+
+const double* RInsideSnapshot::real() const        { return static_cast<const double*>(typed(REALSXP)); }
+const int* RInsideSnapshot::integer() const        { return static_cast<const int*>(typed(INTSXP)); }
+const int* RInsideSnapshot::logical() const        { return static_cast<const int*>(typed(LGLSXP)); }
+const Rbyte* RInsideSnapshot::raw() const          { return static_cast<const Rbyte*>(typed(RAWSXP)); }
+const Rcomplex* RInsideSnapshot::complex() const   { return static_cast<const Rcomplex*>(typed(CPLXSXP)); }
@@ -0,0 +1,63 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Stats.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Stats.h>
+#include <math.h>
+
+void RInsideHistogram::add(double value) {
+    int i = 0;
+    if (value > 1.0) {
+        double m = frexp(value, &i);    // value = m * 2^i, 0.5 <= m < 1
+        if (m == 0.5) i--;              // exactly 2^(i-1), the top of the bucket below
+        if (i >= Buckets) i = Buckets - 1;
+    }
+    buckets_m[i]++;
+    if (count_m == 0 || value < min_m) min_m = value;
+    if (count_m == 0 || value > max_m) max_m = value;
+    count_m++;
+    sum_m += value;
+}
+
+void RInsideHistogram::reset() {
+    for (int i = 0; i < Buckets; i++) buckets_m[i] = 0;
+    count_m = 0;
+    sum_m = min_m = max_m = 0.0;
+}
+
+double RInsideHistogram::bucketUpper(int i) {
+    return ldexp(1.0, i);
+}
+
+double RInsideHistogram::quantile(double q) const {
+    if (count_m == 0) return 0.0;
+    double rank = q * count_m, seen = 0;
+    for (int i = 0; i < Buckets; i++) {
+        if (buckets_m[i] == 0) continue;
+        if (seen + buckets_m[i] >= rank) {
+            double lo = (i == 0) ? 0.0 : bucketUpper(i - 1), hi = bucketUpper(i);
+            double value = lo + (hi - lo) * (rank - seen) / buckets_m[i];
+            return value < min_m ? min_m : (value > max_m ? max_m : value);
+        }
+        seen += buckets_m[i];
+    }
+    return max_m;
+}
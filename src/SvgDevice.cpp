@@ -0,0 +1,460 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// SvgDevice.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <RInside.h>
+#include <SvgDevice.h>
+#include <R_ext/GraphicsEngine.h>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+    void append(std::string& out, const char* fmt, double a) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), fmt, a);
+        out += buf;
+    }
+
+    void appendColour(std::string& out, const char* what, int col) {
+        if (R_TRANSPARENT(col)) {
+            out += " "; out += what; out += "=\"none\"";
+            return;
+        }
+        char buf[64];
+        snprintf(buf, sizeof(buf), " %s=\"#%02x%02x%02x\"", what, R_RED(col), R_GREEN(col), R_BLUE(col));
+        out += buf;
+        if (R_ALPHA(col) != 255) {
+            snprintf(buf, sizeof(buf), " %s-opacity=\"%.3f\"", what, R_ALPHA(col) / 255.0);
+            out += buf;
+        }
+    }
+
+    // R's lwd 1 is 1/96 inch
+    double lineWidth(const pGEcontext gc) {
+        return gc->lwd * 72.0 / 96.0;
+    }
+
+    void appendStroke(std::string& out, const pGEcontext gc) {
+        if (gc->lty == LTY_BLANK) {
+            out += " stroke=\"none\"";
+            return;
+        }
+        appendColour(out, "stroke", gc->col);
+        double lwd = lineWidth(gc);
+        append(out, " stroke-width=\"%.2f\"", lwd);
+        if (gc->lty != LTY_SOLID) {     // dash and gap lengths, one per hex digit
+            out += " stroke-dasharray=\"";
+            unsigned int lty = (unsigned int) gc->lty;
+            for (int i = 0; i < 8 && (lty & 15); i++, lty >>= 4) {
+                if (i > 0) out += ",";
+                append(out, "%.2f", (lty & 15) * lwd);
+            }
+            out += "\"";
+        }
+        switch (gc->lend) {
+        case GE_ROUND_CAP:  out += " stroke-linecap=\"round\"";  break;
+        case GE_SQUARE_CAP: out += " stroke-linecap=\"square\""; break;
+        default:            break;
+        }
+        switch (gc->ljoin) {
+        case GE_ROUND_JOIN: out += " stroke-linejoin=\"round\""; break;
+        case GE_BEVEL_JOIN: out += " stroke-linejoin=\"bevel\""; break;
+        default:
+            append(out, " stroke-miterlimit=\"%.2f\"", gc->lmitre);
+            break;
+        }
+    }
+
+    void appendEscaped(std::string& out, const char* str) {
+        for (; *str; str++) {
+            switch (*str) {
+            case '&': out += "&amp;";  break;
+            case '<': out += "&lt;";   break;
+            case '>': out += "&gt;";   break;
+            case '"': out += "&quot;"; break;
+            default:  out += *str;     break;
+            }
+        }
+    }
+
+    double fontSize(const pGEcontext gc) {
+        return gc->cex * gc->ps;
+    }
+
+    // without a font engine at hand, glyph metrics are those of a
+    // typical sans serif face; the viewer does the actual layout
+    size_t utf8Chars(const char* str) {
+        size_t n = 0;
+        for (; *str; str++) {
+            if ((*str & 0xC0) != 0x80) n++;
+        }
+        return n;
+    }
+}
+
+// Callbacks are called from R's C code, which C++ exceptions must not
+// unwind: whatever the sink or the drawing throws is caught here and raised
+// as an R error once the callback's C++ objects are gone
+#define SVG_CALLBACK_BEGIN                                              \
+    char svg_error[256];                                                \
+    bool svg_failed = false;                                            \
+    try {
+#define SVG_CALLBACK_CATCH                                              \
+    } catch (const std::exception& ex) {                                \
+        snprintf(svg_error, sizeof(svg_error), "%s", ex.what());       \
+        svg_failed = true;                                              \
+    } catch (...) {                                                     \
+        snprintf(svg_error, sizeof(svg_error), "unknown exception");   \
+        svg_failed = true;                                              \
+    }
+#define SVG_CALLBACK_END                                                \
+    SVG_CALLBACK_CATCH                                                  \
+    if (svg_failed) Rf_error("SVG device: %s", svg_error);
+
+struct SvgCallbacks {
+
+    static SvgDevice* device(pDevDesc dd) {
+        return static_cast<SvgDevice*>(dd->deviceSpecific);
+    }
+
+    static void element(pDevDesc dd, const std::string& str) {
+        SvgDevice* dev = device(dd);
+        dev->body_m += str;
+        dev->dirty_m = true;
+    }
+
+    static void open(std::string& out, const char* tag, pDevDesc dd) {
+        out += "<";
+        out += tag;
+        out += device(dd)->clip_m;
+    }
+
+    static void circle(double x, double y, double r, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "circle", dd);
+            append(out, " cx=\"%.2f\"", x);
+            append(out, " cy=\"%.2f\"", y);
+            append(out, " r=\"%.2f\"", r);
+            appendColour(out, "fill", gc->fill);
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void line(double x1, double y1, double x2, double y2, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "line", dd);
+            append(out, " x1=\"%.2f\"", x1);
+            append(out, " y1=\"%.2f\"", y1);
+            append(out, " x2=\"%.2f\"", x2);
+            append(out, " y2=\"%.2f\"", y2);
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void points(std::string& out, int n, double* x, double* y) {
+        out += " points=\"";
+        for (int i = 0; i < n; i++) {
+            append(out, i ? " %.2f" : "%.2f", x[i]);
+            append(out, ",%.2f", y[i]);
+        }
+        out += "\"";
+    }
+
+    static void polyline(int n, double* x, double* y, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "polyline", dd);
+            points(out, n, x, y);
+            out += " fill=\"none\"";
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void polygon(int n, double* x, double* y, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "polygon", dd);
+            points(out, n, x, y);
+            appendColour(out, "fill", gc->fill);
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void path(double* x, double* y, int npoly, int* nper, Rboolean winding, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "path", dd);
+            out += " d=\"";
+            for (int p = 0, k = 0; p < npoly; p++) {
+                for (int i = 0; i < nper[p]; i++, k++) {
+                    out += i ? " L" : "M";
+                    append(out, "%.2f", x[k]);
+                    append(out, ",%.2f", y[k]);
+                }
+                out += " Z ";
+            }
+            out += "\"";
+            out += winding ? " fill-rule=\"nonzero\"" : " fill-rule=\"evenodd\"";
+            appendColour(out, "fill", gc->fill);
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void rect(double x0, double y0, double x1, double y1, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "rect", dd);
+            append(out, " x=\"%.2f\"", x0 < x1 ? x0 : x1);
+            append(out, " y=\"%.2f\"", y0 < y1 ? y0 : y1);
+            append(out, " width=\"%.2f\"", x0 < x1 ? x1 - x0 : x0 - x1);
+            append(out, " height=\"%.2f\"", y0 < y1 ? y1 - y0 : y0 - y1);
+            appendColour(out, "fill", gc->fill);
+            appendStroke(out, gc);
+            out += "/>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static void text(double x, double y, const char* str, double rot, double hadj, const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            std::string out;
+            open(out, "text", dd);
+            append(out, " x=\"%.2f\"", x);
+            append(out, " y=\"%.2f\"", y);
+            if (rot != 0) {
+                append(out, " transform=\"rotate(%.2f", -rot);
+                append(out, ",%.2f", x);
+                append(out, ",%.2f)\"", y);
+            }
+            if (hadj > 0.25) {
+                out += hadj < 0.75 ? " text-anchor=\"middle\"" : " text-anchor=\"end\"";
+            }
+            append(out, " font-size=\"%.2f\"", fontSize(gc));
+            if (gc->fontfamily[0]) {
+                out += " font-family=\"";
+                appendEscaped(out, gc->fontfamily);
+                out += "\"";
+            }
+            if (gc->fontface == 2 || gc->fontface == 4) out += " font-weight=\"bold\"";
+            if (gc->fontface == 3 || gc->fontface == 4) out += " font-style=\"italic\"";
+            appendColour(out, "fill", gc->col);
+            out += ">";
+            appendEscaped(out, str);
+            out += "</text>\n";
+            element(dd, out);
+        SVG_CALLBACK_END
+    }
+
+    static double strWidth(const char* str, const pGEcontext gc, pDevDesc dd) {
+        return 0.6 * fontSize(gc) * utf8Chars(str);
+    }
+
+    static void metricInfo(int c, const pGEcontext gc, double* ascent, double* descent, double* width, pDevDesc dd) {
+        double size = fontSize(gc);
+        *ascent = 0.75 * size;
+        *descent = 0.2 * size;
+        *width = 0.6 * size;
+    }
+
+    static void clip(double x0, double x1, double y0, double y1, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            SvgDevice* dev = device(dd);
+            dd->clipLeft = x0 < x1 ? x0 : x1;
+            dd->clipRight = x0 < x1 ? x1 : x0;
+            dd->clipTop = y0 < y1 ? y0 : y1;
+            dd->clipBottom = y0 < y1 ? y1 : y0;
+            char id[32];
+            snprintf(id, sizeof(id), "c%d", ++dev->clips_m);
+            std::string out = "<clipPath id=\"";
+            out += id;
+            out += "\"><rect";
+            append(out, " x=\"%.2f\"", dd->clipLeft);
+            append(out, " y=\"%.2f\"", dd->clipTop);
+            append(out, " width=\"%.2f\"", dd->clipRight - dd->clipLeft);
+            append(out, " height=\"%.2f\"", dd->clipBottom - dd->clipTop);
+            out += "/></clipPath>\n";
+            dev->body_m += out;
+            dev->clip_m = std::string(" clip-path=\"url(#") + id + ")\"";
+        SVG_CALLBACK_END
+    }
+
+    static void newPage(const pGEcontext gc, pDevDesc dd) {
+        SVG_CALLBACK_BEGIN
+            SvgDevice* dev = device(dd);
+            if (dev->pages_m > 0 && dev->dirty_m) {
+                dev->deliver();
+            }
+            dev->pages_m++;
+            dev->body_m.clear();
+            dev->clips_m = 0;
+            dev->clip_m.clear();
+            dev->dirty_m = true;            // even a blank page is a page
+            if (!R_TRANSPARENT(gc->fill)) {
+                std::string out = "<rect width=\"100%\" height=\"100%\"";
+                appendColour(out, "fill", gc->fill);
+                out += "/>\n";
+                dev->body_m += out;
+            }
+        SVG_CALLBACK_END
+    }
+
+    static void size(double* left, double* right, double* bottom, double* top, pDevDesc dd) {
+        *left = dd->left;
+        *right = dd->right;
+        *bottom = dd->bottom;
+        *top = dd->top;
+    }
+
+    // also reached from SvgDevice::close(), and so from its destructor:
+    // the device goes in any case, and a failing sink only warns
+    static void close(pDevDesc dd) {
+        SvgDevice* dev = device(dd);
+        dev->dev_m = NULL;
+        SVG_CALLBACK_BEGIN
+            if (dev->dirty_m) {
+                dev->deliver();
+            }
+        SVG_CALLBACK_CATCH
+        if (svg_failed) Rf_warning("SVG device: %s", svg_error);
+    }
+
+    static void activate(const pDevDesc dd) {}
+    static void deactivate(pDevDesc dd) {}
+    static void mode(int mode, pDevDesc dd) {}
+};
+
+SvgDevice::SvgDevice(double width, double height, double pointsize, GraphicsSink* sink) :
+    dev_m(NULL), sink_m(sink), width_m(width * 72), height_m(height * 72),
+    pages_m(0), dirty_m(false), clips_m(0) {
+
+    R_GE_checkVersionOrDie(R_GE_version);
+    R_CheckDeviceAvailable();
+
+    pDevDesc dd = static_cast<pDevDesc>(calloc(1, sizeof(DevDesc)));
+    if (dd == NULL) {
+        throw std::runtime_error("Could not allocate the SVG device");
+    }
+    // one device unit is a point, with y running down as in SVG
+    dd->left = dd->clipLeft = 0;
+    dd->right = dd->clipRight = width_m;
+    dd->top = dd->clipTop = 0;
+    dd->bottom = dd->clipBottom = height_m;
+    dd->ipr[0] = dd->ipr[1] = 1.0 / 72;
+    dd->cra[0] = 0.9 * pointsize;
+    dd->cra[1] = 1.2 * pointsize;
+    dd->xCharOffset = 0.4900;
+    dd->yCharOffset = 0.3333;
+    dd->yLineBias = 0.2;
+    dd->gamma = dd->startgamma = 1;
+    dd->canClip = TRUE;
+    dd->canChangeGamma = FALSE;
+    dd->canHAdj = 2;
+    dd->startps = pointsize;
+    dd->startcol = 0xFF000000;          // opaque black on
+    dd->startfill = 0xFFFFFFFF;         // white
+    dd->startlty = LTY_SOLID;
+    dd->startfont = 1;
+    dd->displayListOn = FALSE;
+
+    dd->activate = SvgCallbacks::activate;
+    dd->deactivate = SvgCallbacks::deactivate;
+    dd->close = SvgCallbacks::close;
+    dd->newPage = SvgCallbacks::newPage;
+    dd->size = SvgCallbacks::size;
+    dd->mode = SvgCallbacks::mode;
+    dd->clip = SvgCallbacks::clip;
+    dd->circle = SvgCallbacks::circle;
+    dd->line = SvgCallbacks::line;
+    dd->polyline = SvgCallbacks::polyline;
+    dd->polygon = SvgCallbacks::polygon;
+    dd->path = SvgCallbacks::path;
+    dd->rect = SvgCallbacks::rect;
+    dd->text = dd->textUTF8 = SvgCallbacks::text;
+    dd->strWidth = dd->strWidthUTF8 = SvgCallbacks::strWidth;
+    dd->metricInfo = SvgCallbacks::metricInfo;
+    dd->hasTextUTF8 = TRUE;
+    dd->wantSymbolUTF8 = TRUE;
+    dd->useRotatedTextInContour = TRUE;
+    dd->haveTransparency = 2;
+    dd->haveTransparentBg = 2;
+    dd->haveRaster = 1;                 // no raster images
+    dd->haveCapture = 1;
+    dd->haveLocator = 1;
+    dd->deviceSpecific = this;
+
+    BEGIN_SUSPEND_INTERRUPTS {
+        pGEDevDesc gdd = GEcreateDevDesc(dd);
+        GEaddDevice2(gdd, "rinside_svg");
+        dev_m = gdd;
+    } END_SUSPEND_INTERRUPTS;
+}
+
+SvgDevice::~SvgDevice() {
+    close();
+}
+
+void SvgDevice::close() {
+    if (dev_m) {
+        GEkillDevice(static_cast<pGEDevDesc>(dev_m));   // calls back into SvgCallbacks::close
+    }
+}
+
+void SvgDevice::activate() {
+    if (dev_m == NULL) {
+        throw std::runtime_error("The SVG device has been closed");
+    }
+    selectDevice(GEdeviceNumber(static_cast<pGEDevDesc>(dev_m)));
+}
+
+void SvgDevice::flush() {
+    if (dirty_m && pages_m > 0) {
+        deliver();
+    }
+}
+
+void SvgDevice::deliver() {
+    svg_m.clear();
+    svg_m.reserve(body_m.size() + 256);
+    svg_m += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\"";
+    append(svg_m, " width=\"%.2fpt\"", width_m);
+    append(svg_m, " height=\"%.2fpt\"", height_m);
+    append(svg_m, " viewBox=\"0 0 %.2f", width_m);
+    append(svg_m, " %.2f\">\n", height_m);
+    svg_m += body_m;
+    svg_m += "</svg>\n";
+    dirty_m = false;
+    if (sink_m) {
+        sink_m->page(svg_m.data(), svg_m.size(), pages_m);
+    }
+}
@@ -0,0 +1,224 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// TempDir.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <RInside.h>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#ifndef WIN32
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+extern "C" int setenv(const char *env_var, const char *env_val, int dummy);     // in RInside.cpp
+#endif
+
+// R does not clean up a temporary directory it did not create itself, and
+// an embedding program may well leave via exit() or a signal without
+// running our destructor.  The path is therefore kept in static storage,
+// where both R_TempDir and the exit and signal handlers can use it.  A
+// signal handler cannot walk the directory, so what it leaves is swept up
+// by the next instance, which knows from the process id in the name.
+static char tempdir_path[PATH_MAX];
+
+#ifndef WIN32
+
+static size_t treeBytes(const std::string& path) {
+    size_t bytes = 0;
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL) {
+        return 0;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+        std::string child = path + "/" + ent->d_name;
+        struct stat st;
+        if (lstat(child.c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            bytes += treeBytes(child);
+        } else {
+            bytes += (size_t) st.st_blocks * 512;   // what it takes on a tmpfs
+        }
+    }
+    closedir(dir);
+    return bytes;
+}
+
+// path is a buffer of PATH_MAX bytes, and restored on return
+static void removeTree(char* path, size_t len) {
+    DIR* dir = opendir(path);
+    if (dir != NULL) {
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+            size_t n = strlen(ent->d_name);
+            if (len + 1 + n >= PATH_MAX) continue;
+            path[len] = '/';
+            memcpy(path + len + 1, ent->d_name, n + 1);
+            struct stat st;
+            if (lstat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                removeTree(path, len + 1 + n);
+            } else {
+                unlink(path);
+            }
+            path[len] = '\0';
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+static void removeTempDirAtExit(void) {
+    if (tempdir_path[0]) {
+        removeTree(tempdir_path, strlen(tempdir_path));
+        tempdir_path[0] = '\0';
+    }
+}
+
+static const int cleanup_signals[] = { SIGHUP, SIGINT, SIGQUIT, SIGTERM };
+static struct sigaction previous_actions[sizeof(cleanup_signals) / sizeof(int)];
+
+// only async-signal-safe calls here: the directory goes if it is empty
+static void removeTempDirOnSignal(int sig) {
+    if (tempdir_path[0]) {
+        rmdir(tempdir_path);
+    }
+    for (size_t i = 0; i < sizeof(cleanup_signals) / sizeof(int); i++) {
+        if (cleanup_signals[i] == sig) {
+            sigaction(sig, &previous_actions[i], NULL);     // hand over to whoever was there before
+            break;
+        }
+    }
+    raise(sig);
+}
+
+static void installCleanup(void) {
+    static bool installed = false;
+    if (installed) return;
+    installed = true;
+    atexit(removeTempDirAtExit);
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = removeTempDirOnSignal;
+    sigemptyset(&act.sa_mask);
+    for (size_t i = 0; i < sizeof(cleanup_signals) / sizeof(int); i++) {
+        sigaction(cleanup_signals[i], NULL, &previous_actions[i]);
+        if ((previous_actions[i].sa_flags & SA_SIGINFO) ||
+            previous_actions[i].sa_handler != SIG_DFL) continue;   // eg nohup, or the host's own
+        sigaction(cleanup_signals[i], &act, NULL);
+    }
+}
+
+// directories left behind in base by instances which died of a signal
+static void sweepStale(const char* base) {
+    DIR* dir = opendir(base);
+    if (dir == NULL) {
+        return;
+    }
+    char path[PATH_MAX];
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "RInside-", 8) != 0) continue;
+        char* end;
+        long pid = strtol(ent->d_name + 8, &end, 10);
+        if (end == ent->d_name + 8 || *end != '-' || pid <= 0 || pid == (long) getpid()) continue;
+        if (kill((pid_t) pid, 0) == 0 || errno != ESRCH) continue;     // alive, or not ours to know
+        int len = snprintf(path, sizeof(path), "%s/%s", base, ent->d_name);
+        if (len > 0 && len < (int) sizeof(path)) {
+            removeTree(path, len);
+        }
+    }
+    closedir(dir);
+}
+
+#endif
+
+void RInside::init_tempdir(const std::string& base) {
+    const char *tmp = base.empty() ? NULL : base.c_str();
+    if (tmp == NULL) tmp = getenv("TMPDIR");
+    if (tmp == NULL) tmp = getenv("TMP");
+    if (tmp == NULL) tmp = getenv("TEMP");
+    if (tmp == NULL) tmp = "/tmp";
+
+#ifndef WIN32
+    // a directory of our own, as R would make in its own startup code
+    sweepStale(tmp);
+    char pid[32];
+    snprintf(pid, sizeof(pid), "%ld", (long) getpid());
+    std::string templ = std::string(tmp) + "/RInside-" + pid + "-XXXXXX";
+    if (templ.size() >= sizeof(tempdir_path)) {
+        throw std::runtime_error(std::string("Temporary directory path too long: ") + templ);
+    }
+    strcpy(tempdir_path, templ.c_str());
+    if (mkdtemp(tempdir_path) == NULL) {
+        int err = errno;
+        tempdir_path[0] = '\0';
+        throw std::runtime_error(std::string("Could not create a temporary directory in ") +
+                                 std::string(tmp) + ": " + strerror(err));
+    }
+    installCleanup();
+#else
+    // no mkdtemp(), so share the directory as before and leave it in place
+    strncpy(tempdir_path, tmp, sizeof(tempdir_path) - 1);
+#endif
+    R_TempDir = tempdir_path;
+    if (setenv("R_SESSION_TMPDIR", tempdir_path, 1) != 0){
+        throw std::runtime_error(std::string("Could not set / replace R_SESSION_TMPDIR to ") + std::string(tempdir_path));
+    }
+}
+
+void RInside::removeTempDir(void) {
+#ifndef WIN32
+    removeTempDirAtExit();
+#endif
+}
+
+std::string RInside::tempDir() const {
+    return std::string(R_TempDir ? R_TempDir : "");
+}
+
+size_t RInside::tempBytes() const {
+#ifndef WIN32
+    return tempdir_path[0] ? treeBytes(tempdir_path) : 0;
+#else
+    return 0;
+#endif
+}
+
+// walking the tree takes a while with many files, so not after every
+// evaluation: an overrun shows at the first one a second after the last walk
+void RInside::checkTempLimit(void) {
+    double now = monotonicUsec();
+    if (now - temp_checked_m < 1e6) {
+        return;
+    }
+    temp_exceeded_m = tempBytes() > temp_limit_m;
+    temp_checked_m = monotonicUsec();
+    if (temp_exceeded_m && verbose_m) {
+        Rf_warning("RInside: Temporary directory over its limit\n");
+    }
+}
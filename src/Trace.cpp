@@ -0,0 +1,190 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// Trace.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Trace.h>
+#include <Mutex.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+volatile bool RInsideTrace::enabled_m = false;
+
+namespace {
+
+    // Written by its own thread only.  The writer fills a slot before it
+    // publishes the new head; a reader copies, then looks at the head again
+    // to find out which of the copied slots may have been overwritten.
+    struct Ring {
+        std::vector<RInsideTrace::Event> events;
+        volatile size_t head;           // events ever recorded
+        unsigned long tid;
+        std::string thread;
+        bool dead;                      // its thread has exited
+    };
+
+    RInsideMutex rings_mutex;           // guards rings and the size of new ones, not their contents
+    std::vector<Ring*> rings;           // kept after their thread exits, until dumped or cleared
+    size_t ring_size = 65536;
+    pthread_key_t ring_key;
+    pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+    unsigned long next_tid = 1;
+
+    void ringExit(void* ring) {
+        RInsideMutexLock lock(rings_mutex);
+        static_cast<Ring*>(ring)->dead = true;
+    }
+
+    void makeKey() {
+        pthread_key_create(&ring_key, ringExit);
+    }
+
+    void dropDead() {                   // with rings_mutex held
+        size_t kept = 0;
+        for (size_t i = 0; i < rings.size(); i++) {
+            if (rings[i]->dead) {
+                delete rings[i];
+            } else {
+                rings[kept++] = rings[i];
+            }
+        }
+        rings.resize(kept);
+    }
+
+    Ring* threadRing() {
+        pthread_once(&ring_once, makeKey);
+        Ring* ring = static_cast<Ring*>(pthread_getspecific(ring_key));
+        if (ring == NULL) {
+            ring = new Ring;
+            ring->head = 0;
+            ring->dead = false;
+            RInsideMutexLock lock(rings_mutex);
+            ring->events.resize(ring_size);
+            ring->tid = next_tid++;
+            rings.push_back(ring);
+            pthread_setspecific(ring_key, ring);
+        }
+        return ring;
+    }
+
+    void appendEscaped(std::string& out, const char* str) {
+        for (; *str; str++) {
+            unsigned char c = (unsigned char) *str;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char) c;
+            } else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += (char) c;
+            }
+        }
+    }
+}
+
+void RInsideTrace::enable(size_t eventsPerThread) {
+    RInsideMutexLock lock(rings_mutex);
+    ring_size = eventsPerThread > 0 ? eventsPerThread : 1;
+    enabled_m = true;
+}
+
+void RInsideTrace::disable() {
+    enabled_m = false;
+}
+
+// events being recorded meanwhile may survive
+void RInsideTrace::clear() {
+    RInsideMutexLock lock(rings_mutex);
+    dropDead();
+    for (size_t i = 0; i < rings.size(); i++) {
+        rings[i]->head = 0;
+    }
+}
+
+void RInsideTrace::record(const char* category, const char* name, double start, double duration) {
+    if (!enabled_m) return;
+    Ring* ring = threadRing();
+    size_t head = ring->head;
+    Event& ev = ring->events[head % ring->events.size()];
+    strncpy(ev.name, name, sizeof(ev.name) - 1);
+    ev.name[sizeof(ev.name) - 1] = '\0';
+    ev.category = category;
+    ev.start = start;
+    ev.duration = duration;
+    __sync_synchronize();
+    ring->head = head + 1;
+}
+
+void RInsideTrace::setThreadName(const std::string& name) {
+    Ring* ring = threadRing();
+    RInsideMutexLock lock(rings_mutex);
+    ring->thread = name;
+}
+
+std::string RInsideTrace::chromeJson() {
+    std::string out = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    char buf[160];
+    long pid = (long) getpid();
+    bool first = true;
+    RInsideMutexLock lock(rings_mutex);
+    for (size_t r = 0; r < rings.size(); r++) {
+        Ring* ring = rings[r];
+        size_t size = ring->events.size();
+        if (!ring->thread.empty()) {
+            snprintf(buf, sizeof(buf), "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %ld, \"tid\": %lu, \"args\": {\"name\": \"",
+                     first ? "" : ",\n", pid, ring->tid);
+            out += buf;
+            appendEscaped(out, ring->thread.c_str());
+            out += "\"}}";
+            first = false;
+        }
+        size_t head = ring->head;
+        __sync_synchronize();
+        size_t from = head > size ? head - size : 0;
+        std::vector<Event> copy;
+        copy.reserve(head - from);
+        for (size_t i = from; i < head; i++) {
+            copy.push_back(ring->events[i % size]);
+        }
+        __sync_synchronize();
+        size_t now = ring->head;
+        size_t valid = now + 1 > size ? now + 1 - size : 0;     // older slots were reused, or are being, while copying
+        for (size_t i = std::max(from, valid); i < head; i++) {
+            const Event& ev = copy[i - from];
+            out += first ? "" : ",\n";
+            out += "{\"name\": \"";
+            appendEscaped(out, ev.name);
+            out += "\", \"cat\": \"";
+            appendEscaped(out, ev.category);
+            snprintf(buf, sizeof(buf), "\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %ld, \"tid\": %lu}",
+                     ev.start, ev.duration, pid, ring->tid);
+            out += buf;
+            first = false;
+        }
+    }
+    dropDead();                         // their events are out now
+    out += "\n]}\n";
+    return out;
+}
@@ -0,0 +1,207 @@
+// -*- mode: C++; c-indent-level: 4; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+//
+// WorkQueue.cpp: R/C++ interface class library -- Easier R embedding into C++
+//
+// Copyright (C) 2026  Dirk Eddelbuettel and Romain Francois
+//
+// This file is part of RInside.
+//
+// RInside is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// RInside is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RInside.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <climits>
+
+#include <RInside.h>
+#include <WorkQueue.h>
+
+WorkQueue::Job::Job() : queue_m(NULL), priority_m(Normal), done_m(false), error_m(), submitted_m(0) {}
+
+WorkQueue::Job::~Job() {}
+
+void WorkQueue::Job::wait() {
+    if (queue_m == NULL) return;        // never submitted
+    RInsideMutexLock lock(queue_m->mutex_m);
+    while (!done_m) {
+        queue_m->done_m.wait(queue_m->mutex_m);
+    }
+}
+
+bool WorkQueue::Job::done() {
+    if (queue_m == NULL) return false;
+    RInsideMutexLock lock(queue_m->mutex_m);
+    return done_m;
+}
+
+void WorkQueue::EvalJob::run(RInside& R) {
+    R.parseEvalQ(code_m);
+}
+
+WorkQueue::WorkQueue(RInside& R) : R_m(R), shutdown_m(false), idle_usec_m(0), idle_full_m(false), ran_m(false) {
+    for (int p = 0; p < Priorities; p++) {
+        budget_m[p] = INT_MAX;
+        streak_m[p] = 0;
+    }
+}
+
+WorkQueue::~WorkQueue() {
+    if (R_m.getWorkQueue() == this) {
+        R_m.setWorkQueue(NULL);
+    }
+}
+
+void WorkQueue::setBudget(Priority priority, int maxInARow) {
+    RInsideMutexLock lock(mutex_m);
+    budget_m[priority] = (maxInARow >= 0) ? maxInARow : INT_MAX;
+    queued_m.signal();                  // held back jobs may have become eligible
+}
+
+void WorkQueue::submit(Job* job, Priority priority) {
+    RInsideMutexLock lock(mutex_m);
+    job->queue_m = this;
+    job->priority_m = priority;
+    job->done_m = false;
+    job->error_m.clear();
+    job->submitted_m = RInsideTrace::enabled() ? monotonicUsec() : 0;
+    queue_m[priority].push_back(job);
+    queued_m.signal();
+}
+
+size_t WorkQueue::depth() {
+    RInsideMutexLock lock(mutex_m);
+    size_t n = 0;
+    for (int p = 0; p < Priorities; p++) {
+        n += queue_m[p].size();
+    }
+    return n;
+}
+
+// whether anything less urgent than class p is held up by it: a suspended
+// job, or one queued in a class allowed to run at all
+bool WorkQueue::waiting(int p, int below) {
+    if (below < Priorities) return true;
+    for (int q = p + 1; q < Priorities; q++) {
+        if (!queue_m[q].empty() && budget_m[q] > 0) return true;
+    }
+    return false;
+}
+
+// highest class first; only classes numerically below 'below' qualify, and
+// of those none which has had its budget of jobs in a row while others wait
+int WorkQueue::eligible(int below) {
+    for (int p = 0; p < below; p++) {
+        if (queue_m[p].empty() || budget_m[p] == 0) continue;
+        if (streak_m[p] >= budget_m[p] && waiting(p, below)) continue;
+        return p;
+    }
+    return -1;
+}
+
+WorkQueue::Job* WorkQueue::take(int below) {
+    int p = eligible(below);
+    if (p < 0) return NULL;
+    Job* job = queue_m[p].front();
+    queue_m[p].pop_front();
+    streak_m[p]++;
+    for (int q = 0; q < p; q++) {       // the more urgent classes' run is over
+        streak_m[q] = 0;
+    }
+    running_m.push_back(static_cast<Priority>(p));
+    return job;
+}
+
+void WorkQueue::execute(Job* job) {
+    static const char* names[Priorities] = { "job interactive", "job normal", "job batch" };
+    std::string error;
+    if (RInsideTrace::enabled() && job->submitted_m > 0) {
+        RInsideTrace::record("queue", "wait", job->submitted_m, monotonicUsec() - job->submitted_m);
+    }
+    RInsideTraceSpan span("queue", names[job->priority_m]);
+    try {
+        job->run(R_m);
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    } catch (...) {
+        error = "unknown exception";
+    }
+    RInsideMutexLock lock(mutex_m);
+    running_m.pop_back();
+    ran_m = true;
+    job->error_m = error;
+    job->done_m = true;
+    done_m.broadcast();
+}
+
+bool WorkQueue::runOne() {
+    Job* job;
+    {
+        RInsideMutexLock lock(mutex_m);
+        job = take(running_m.empty() ? Priorities : running_m.back());
+    }
+    if (job == NULL) return false;
+    execute(job);
+    return true;
+}
+
+void WorkQueue::runPending() {
+    while (runOne()) {}
+}
+
+// collections then happen while nobody waits on R instead of in the
+// middle of the next request
+void WorkQueue::setIdleCollection(long usec, bool full) {
+    RInsideMutexLock lock(mutex_m);
+    idle_usec_m = usec;
+    idle_full_m = full;
+}
+
+void WorkQueue::run() {
+    for (;;) {
+        runPending();
+        bool collect = false;
+        {
+            RInsideMutexLock lock(mutex_m);
+            if (shutdown_m) break;
+            if (eligible(Priorities) < 0) {
+                if (idle_usec_m > 0 && ran_m) {
+                    collect = !queued_m.wait(mutex_m, idle_usec_m) && !shutdown_m && eligible(Priorities) < 0;
+                } else {
+                    queued_m.wait(mutex_m);
+                }
+            }
+            if (collect) ran_m = false;
+        }
+        if (collect) {
+            R_m.gc(idle_full_m);
+        }
+    }
+}
+
+void WorkQueue::shutdown() {
+    RInsideMutexLock lock(mutex_m);
+    shutdown_m = true;
+    queued_m.broadcast();
+}
+
+// between two top-level expressions of a running job: let strictly more
+// urgent work go first; plain parseEval() calls outside of a job never yield
+void WorkQueue::yieldPoint() {
+    {
+        RInsideMutexLock lock(mutex_m);
+        if (running_m.empty()) return;
+    }
+    runPending();
+    RInsideMutexLock lock(mutex_m);     // the suspended job gets its turn now
+    for (int q = 0; q < running_m.back(); q++) {
+        streak_m[q] = 0;
+    }
+}